@@ -6,12 +6,34 @@
 #include <util/delay.h>
 
 #include "Config/LightweightConfig.h"
+#include "Ethernet/EmbeddedSocketInterface.h"
+#include "Ethernet/LinkMonitor.h"
+#include "Ethernet/PhyPower.h"
 #include "Ethernet/W5500/W5500Interface.h"
 #include "MQTT/MinimalMQTT.h"
+#include "MQTT/ResponseStream.h"
+#ifdef ENABLE_MQTT_SN
+#include "MQTT/MinimalMQTTSN.h"
+#endif
+#ifdef ENABLE_RING_GROUP
+#include "Network/RingGroupNode.h"
+#endif
+#ifdef ENABLE_TCP_CONSOLE
+#include "Network/TcpConsole.h"
+#endif
+#ifdef ENABLE_DHCP
+#include "Network/DHCPClient.h"
+#endif
+#ifdef ENABLE_DNS
+#include "Network/DNSClient.h"
+#endif
 #include "Serial/SPI.h"
 #include "Serial/UART.h"
 #include "SetupTimer.h"
 #include "SetupWDT.h"
+#include "System/EventSequence.h"
+#include "System/LogFilter.h"
+#include "System/StackMonitor.h"
 #include "System/TimerService.h"
 
 // ===== HARDWARE KONSTANTEN =====
@@ -31,32 +53,105 @@ struct ChimeState {
   uint32_t ring_start_ms;
 
   const char* pub_topic;
+  MQTT::PreparedPublish pub_packet;  // PUBLISH header for pub_topic, see prepare_chime_packets()
   bool button_pressed;
   bool mqtt_sent;
 
   bool last_raw_state;
   uint32_t last_debounce_ms;
   uint32_t last_event_ms;
+  uint32_t event_sequence;  // Gleiche Nummer für alle Retries eines Tastendrucks
 };
 
+// Button events are retried this long after the press (age in the envelope stays < 16 bit)
+static constexpr uint32_t kEventRetryWindowMs = 10000;
+
 // Definition der beiden Klingel-Module
 static ChimeState chime1 = {(1 << PORTB0), &PORTB, (1 << PORTD2), &PIND, true, false, false, 0,
-                            nullptr,       false,  false,         true,  0,    0};
+                            nullptr,       {},     false,         false, true,  0,     0, 0};
 static ChimeState chime2 = {(1 << PORTB1), &PORTB, (1 << PORTD3), &PIND, true, false, false, 0,
-                            nullptr,       false,  false,         true,  0,    0};
+                            nullptr,       {},     false,         false, true,  0,     0, 0};
 
 static serial::UART* g_uart = nullptr;
 static serial::SPI* g_spi = nullptr;
 static MQTT::MinimalMQTT* g_mqtt_client = nullptr;
+#ifdef ENABLE_MQTT_SN
+// MQTT-SN Fast-Path: Gateway auf der Broker-IP, Topic-IDs dort vordefiniert
+static MQTT::MinimalMQTTSN* g_mqtt_sn = nullptr;
+static constexpr uint16_t kSnTopicChime1 = 1;
+static constexpr uint16_t kSnTopicChime2 = 2;
+#endif
+#ifdef ENABLE_RING_GROUP
+// LAN Ring-Gruppe: Gong-Bit 0 = chime1, Bit 1 = chime2
+static Network::RingGroupNode* g_ring_group = nullptr;
+#endif
+#ifdef ENABLE_TCP_CONSOLE
+// Telnet-Konsole auf Socket 5, spiegelt die Konsolen-Ausgabe auf die UART
+static Network::TcpConsole* g_tcp_console = nullptr;
+#endif
+#ifdef ENABLE_DHCP
+// DHCP auf Socket 0, aktiv wenn die Geräte-IP 0.0.0.0 ist (nullptr: statische IP)
+static SmartBell::DHCPClient* g_dhcp = nullptr;
+#endif
+#ifdef ENABLE_DNS
+// Broker-Hostname auf Socket 1: gecachte Adresse sofort, Refresh im Hintergrund
+static SmartBell::DNSClient* g_dns = nullptr;
+#endif
 static Config::LightweightConfig* g_config = nullptr;
 static Ethernet::W5500Interface* g_w5500 = nullptr;
+// PHY-Link alle 250 ms: Sockets sofort abbauen bzw. sofort neu verbinden
+static Ethernet::LinkMonitor* g_link = nullptr;
+// PHY-Profil: loggt Moduswechsel und Link-Up-Latenz, schläft mit ENABLE_PHY_SLEEP
+static Ethernet::PhyPower* g_phy = nullptr;
+#if defined(ENABLE_PHY_SLEEP)
+static constexpr Ethernet::PhyProfile kPhyProfile = Ethernet::PhyProfile::k10BaseTSleep;
+#elif defined(ENABLE_PHY_10M)
+static constexpr Ethernet::PhyProfile kPhyProfile = Ethernet::PhyProfile::k10BaseT;
+#else
+static constexpr Ethernet::PhyProfile kPhyProfile = Ethernet::PhyProfile::kAutoNegotiation;
+#endif
+
+// UDP-Empfänger, die nur bei einem RECV-Event (SIR) ihren RX-Puffer lesen
+static constexpr uint8_t kPolledSockets = 0
+#ifdef ENABLE_DHCP
+                                          | (1 << SmartBell::DHCPClient::kDHCPSocket)
+#endif
+#ifdef ENABLE_DNS
+                                          | (1 << SmartBell::DNSClient::kDNSSocket)
+#endif
+#ifdef ENABLE_RING_GROUP
+                                          | (1 << Network::RingGroupNode::kSocketNumber)
+#endif
+    ;
+
+// Socket-Nummern der Module passend zur Speicheraufteilung (SocketMemoryMap.h)
+static_assert(MQTT::MinimalMQTT::kMQTTSocketNumber == Ethernet::kSocketMQTT, "MQTT socket");
+#ifdef ENABLE_MQTT_SN
+static_assert(MQTT::MinimalMQTTSN::kSocketNumber == Ethernet::kSocketMQTTSN, "MQTT-SN socket");
+#endif
+#ifdef ENABLE_RING_GROUP
+static_assert(Network::RingGroupNode::kSocketNumber == Ethernet::kSocketRingGroup, "Ring socket");
+#endif
+#ifdef ENABLE_TCP_CONSOLE
+static_assert(Network::TcpConsole::kSocketNumber == Ethernet::kSocketConsole, "Console socket");
+#endif
+#ifdef ENABLE_DHCP
+static_assert(SmartBell::DHCPClient::kDHCPSocket == Ethernet::kSocketDHCP, "DHCP socket");
+#endif
+#ifdef ENABLE_DNS
+static_assert(SmartBell::DNSClient::kDNSSocket == Ethernet::kSocketDNS, "DNS socket");
+#endif
 
 char cmd_buffer[64];
 uint8_t cmd_index = 0;
 
 extern "C" {
+// MCUSR wird in .init3 gelöscht, vorher für main() sichern
+uint8_t g_reset_flags __attribute__((section(".noinit")));
+
 void disable_wdt_early(void) __attribute__((naked)) __attribute__((section(".init3")));
 void disable_wdt_early(void) {
+  g_reset_flags = MCUSR;
   MCUSR = 0;
   wdt_disable();
 }
@@ -84,13 +179,15 @@ void init_chime(ChimeState& chime) {
 }
 
 void on_mqtt_message_received(const char* topic, const uint8_t* payload, uint16_t length) {
-  print_log_ptr(g_uart, PSTR("[MQTT] CMD RX on: "));
-  g_uart->send_string(topic);
-  print_log_ptr(g_uart, PSTR("Payload: "));
-  for (uint16_t i = 0; i < length; i++) {
-    g_uart->send(payload[i]);
+  if (System::log_enabled(System::LogModule::kMQTT, System::LogLevel::kDebug)) {
+    print_log_ptr(g_uart, PSTR("[MQTT] CMD RX on: "));
+    g_uart->send_string(topic);
+    print_log_ptr(g_uart, PSTR("Payload: "));
+    for (uint16_t i = 0; i < length; i++) {
+      g_uart->send(payload[i]);
+    }
+    print_log_ptr(g_uart, PSTR("\r\n"));
   }
-  print_log_ptr(g_uart, PSTR("\r\n"));
 
   ChimeState* target_chime = nullptr;
   uint16_t t_len = strlen(topic);
@@ -106,34 +203,290 @@ void on_mqtt_message_received(const char* topic, const uint8_t* payload, uint16_
   if (!target_chime)
     return;
 
-  if (length >= 2 && strncmp(reinterpret_cast<const char*>(payload), "ON", 2) == 0) {
+  const char* text = reinterpret_cast<const char*>(payload);
+  if (length >= 2 && strncmp_P(text, PSTR("ON"), 2) == 0) {
     target_chime->enabled = true;
-    print_log_ptr(g_uart, PSTR("[BELL] Chime enabled\r\n"));
-  } else if (length >= 3 && strncmp(reinterpret_cast<const char*>(payload), "OFF", 3) == 0) {
+    SB_LOG_INFO(g_uart, kBELL, "[BELL] Chime enabled\r\n");
+  } else if (length >= 3 && strncmp_P(text, PSTR("OFF"), 3) == 0) {
     target_chime->enabled = false;
-    print_log_ptr(g_uart, PSTR("[BELL] Chime disabled\r\n"));
-  } else if (length >= 4 && strncmp(reinterpret_cast<const char*>(payload), "RING", 4) == 0) {
+    SB_LOG_INFO(g_uart, kBELL, "[BELL] Chime disabled\r\n");
+  } else if (length >= 4 && strncmp_P(text, PSTR("RING"), 4) == 0) {
     target_chime->trigger_pending = true;
-    print_log_ptr(g_uart, PSTR("[BELL] Ring triggered via MQTT\r\n"));
+    SB_LOG_INFO(g_uart, kBELL, "[BELL] Ring triggered via MQTT\r\n");
+  }
+}
+
+#ifdef ENABLE_RING_GROUP
+// Klingeln einer anderen Klingel der Gruppe: nur den Gong auslösen, kein MQTT-Event
+void on_group_ring(uint8_t gong_mask) {
+  if (gong_mask & 0x01) {
+    chime1.trigger_pending = true;
+  }
+  if (gong_mask & 0x02) {
+    chime2.trigger_pending = true;
   }
 }
+#endif
+
+// Rebuilds the cached PUBLISH headers of both buttons. Called after every
+// console command, so a changed input topic is never sent with a stale length.
+void prepare_chime_packets() {
+  chime1.pub_packet =
+      MQTT::MinimalMQTT::prepare_publish(chime1.pub_topic, System::kEventEnvelopeLength);
+  chime2.pub_packet =
+      MQTT::MinimalMQTT::prepare_publish(chime2.pub_topic, System::kEventEnvelopeLength);
+}
 
-void mqtt_subscribe_topics(const Config::SmartBellConfig& cfg) {
-  if (!g_mqtt_client->is_connected())
+// Remote console: "<client_id>/cmd" with payload "<id> <command>", the output
+// comes back as "<id>:<text>" chunks and a final "<id>." on "<client_id>/cmd/resp"
+static char g_cmd_topic[sizeof(Config::SmartBellConfig::client_id) + 4];
+static char g_resp_topic[sizeof(Config::SmartBellConfig::client_id) + 9];
+
+// Longest remote command, limited by the 64 byte MQTT receive buffer anyway
+static constexpr uint8_t kMaxRemoteCommandLength = 40;
+
+// Runs directly in the MQTT loop(): the command is copied to the stack and
+// answered with QoS 0 chunks, nothing stays buffered afterwards.
+void on_remote_command(const char* topic, const uint8_t* payload, uint16_t length) {
+  const char* text = reinterpret_cast<const char*>(payload);
+  const char* space = static_cast<const char*>(memchr(text, ' ', length));
+  uint16_t cmd_length = (space != nullptr) ? length - (space - text) - 1 : 0;
+  if (space == nullptr || cmd_length == 0 || cmd_length > kMaxRemoteCommandLength) {
+    SB_LOG_WARN(g_uart, kMQTT, "[MQTT] Remote cmd rejected\r\n");
     return;
+  }
+
+  char command[kMaxRemoteCommandLength + 1];
+  memcpy(command, space + 1, cmd_length);
+  command[cmd_length] = '\0';
+  if (System::log_enabled(System::LogModule::kMQTT, System::LogLevel::kInfo)) {
+    print_log_ptr(g_uart, PSTR("[MQTT] Remote cmd: "));
+    g_uart->send_string(command);
+    print_log_ptr(g_uart, PSTR("\r\n"));
+  }
+
+  MQTT::ResponseStream response(*g_mqtt_client, g_resp_topic, text,
+                                static_cast<uint8_t>(space - text));
+  if (!System::process_mem_command(command, response)) {
+    g_config->process_command(command, response);
+  }
+  response.finish();
+  prepare_chime_packets();
+}
 
+// Registers the gong control and console topics. MinimalMQTT keeps them across
+// reconnects and sends one SUBSCRIBE for all of them together with the next CONNECT.
+void mqtt_register_topics(const Config::SmartBellConfig& cfg) {
+  // Referenced by the subscription table, so it has to stay static.
+  // One "<base>/+" filter covers both chimes, on_mqtt_message_received picks
+  // the chime from the last topic level.
   static char sub_topic[MQTT::kMaxTopicLength];
 
-  strncpy(sub_topic, cfg.gong_base_topic, MQTT::kMaxTopicLength - 3);
-  sub_topic[MQTT::kMaxTopicLength - 3] = '\0';
-  strcat(sub_topic, "/1");
-  g_mqtt_client->subscribe(sub_topic, on_mqtt_message_received);
+  g_mqtt_client->clear_subscriptions();
 
   strncpy(sub_topic, cfg.gong_base_topic, MQTT::kMaxTopicLength - 3);
   sub_topic[MQTT::kMaxTopicLength - 3] = '\0';
-  strcat(sub_topic, "/2");
+  strcat_P(sub_topic, PSTR("/+"));
   g_mqtt_client->subscribe(sub_topic, on_mqtt_message_received);
+
+  strncpy(g_cmd_topic, cfg.client_id, sizeof(cfg.client_id) - 1);
+  g_cmd_topic[sizeof(cfg.client_id) - 1] = '\0';
+  strcpy(g_resp_topic, g_cmd_topic);
+  strcat_P(g_cmd_topic, PSTR("/cmd"));
+  strcat_P(g_resp_topic, PSTR("/cmd/resp"));
+  g_mqtt_client->subscribe(g_cmd_topic, on_remote_command);
+}
+
+// A persistent session lets the broker keep our filters, so a reconnect needs
+// no SUBSCRIBE at all. After boot and after a topic change the next connect
+// starts clean once (SUBSCRIBE pipelined behind CONNECT), otherwise a resumed
+// session could keep outdated filters.
+bool g_mqtt_clean_pending = true;
+
+// Broker-Adresse: aufgelöster Hostname (falls gesetzt) oder die feste Broker-IP
+bool broker_address(const Config::SmartBellConfig& cfg, uint8_t* ip) {
+#ifdef ENABLE_DNS
+  if (g_dns->has_hostname()) {
+    return g_dns->get_ip(ip);
+  }
+#endif
+  memcpy(ip, cfg.broker_ip, 4);
+  return (ip[0] | ip[1] | ip[2] | ip[3]) != 0;
+}
+
+void fill_mqtt_config(const Config::SmartBellConfig& cfg, const uint8_t* broker_ip,
+                      MQTT::Config& mqtt_cfg) {
+  // "<client_id>/status", retained: "online" nach CONNACK, "offline" vom Broker
+  // als Last Will, sobald 1.5x Keepalive ohne Lebenszeichen vergangen sind
+  static char status_topic[sizeof(cfg.client_id) + 7];
+
+  memcpy(mqtt_cfg.broker_ip, broker_ip, 4);
+  mqtt_cfg.broker_port = cfg.broker_port;
+  strncpy(mqtt_cfg.client_id, cfg.client_id, MQTT::kMaxClientIdLength);
+  mqtt_cfg.client_id[MQTT::kMaxClientIdLength - 1] = '\0';
+  mqtt_cfg.use_auth = false;
+  mqtt_cfg.keepalive = 60;
+  mqtt_cfg.clean_session = g_mqtt_clean_pending;
+  // RTR aus der gemessenen RTT: toter Broker fällt im LAN nach < 1 s auf statt nach ~30 s
+  mqtt_cfg.retry_time_ms = 0;
+  mqtt_cfg.retry_count = MQTT::kDefaultRetryCount;
+
+  strncpy(status_topic, cfg.client_id, sizeof(cfg.client_id) - 1);
+  status_topic[sizeof(cfg.client_id) - 1] = '\0';
+  strcat_P(status_topic, PSTR("/status"));
+  mqtt_cfg.will_topic = status_topic;
+  mqtt_cfg.will_payload = MQTT::kPresenceOffline;
+  mqtt_cfg.birth_payload = MQTT::kPresenceOnline;
+  mqtt_cfg.presence_in_flash = true;
+  mqtt_cfg.will_qos = MQTT::QoS::kAtLeastOnce;
+  mqtt_cfg.will_retain = true;
+}
+
+// Statische IP ist mit Link sofort nutzbar, mit DHCP erst nach dem ACK
+bool network_up() {
+  if (!g_phy->is_ready() || !g_link->is_up()) {
+    return false;
+  }
+#ifdef ENABLE_DHCP
+  return g_dhcp == nullptr || g_dhcp->has_ip();
+#else
+  return true;
+#endif
+}
+
+void print_u32(uint32_t value, serial::Interface* out = g_uart) {
+  char buffer[11];
+  uint8_t i = sizeof(buffer) - 1;
+  buffer[i] = '\0';
+  do {
+    buffer[--i] = static_cast<char>('0' + value % 10);
+    value /= 10;
+  } while (value > 0);
+  out->send_string(&buffer[i]);
+}
+
+// "sockets": Belegung und Höchststand der W5500-Puffer, z.B. nach einem
+// Schwall retained Messages (MQTT-RX-Fenster zu klein?)
+bool process_socket_command(const char* command, serial::Interface& out) {
+  if (strcmp_P(command, PSTR("sockets")) != 0) {
+    return false;
+  }
+  for (uint8_t sn = 0; sn < Ethernet::kSocketCount; sn++) {
+    uint8_t tx_kb = Ethernet::kSocketMemoryMap.tx_kb[sn];
+    uint8_t rx_kb = Ethernet::kSocketMemoryMap.rx_kb[sn];
+    if (tx_kb == 0 && rx_kb == 0) {
+      continue;
+    }
+    Ethernet::SocketBufferUse use = g_w5500->buffer_use(sn);
+    print_log_ptr(&out, PSTR("S"));
+    print_u32(sn, &out);
+    print_log_ptr(&out, PSTR(" tx "));
+    print_u32(use.tx_used, &out);
+    print_log_ptr(&out, PSTR("/"));
+    print_u32(tx_kb * 1024UL, &out);
+    print_log_ptr(&out, PSTR(" max "));
+    print_u32(use.tx_high, &out);
+    print_log_ptr(&out, PSTR(", rx "));
+    print_u32(use.rx_used, &out);
+    print_log_ptr(&out, PSTR("/"));
+    print_u32(rx_kb * 1024UL, &out);
+    print_log_ptr(&out, PSTR(" max "));
+    print_u32(use.rx_high, &out);
+    print_log_ptr(&out, PSTR("\r\n"));
+  }
+  return true;
+}
+
+// Messpunkt für den Kompromiss Link-Up-Latenz gegen Leistung der PHY-Profile
+void on_phy_event(Ethernet::PhyEvent event, Ethernet::PhyMode mode, uint32_t elapsed_ms) {
+  if (event == Ethernet::PhyEvent::kLinkUp) {
+    SB_LOG_INFO(g_uart, kNET, "[PHY] Link up after %u ms\r\n", elapsed_ms);
+  } else if (event == Ethernet::PhyEvent::kLinkTimeout) {
+    SB_LOG_WARN(g_uart, kNET, "[PHY] No link after %u ms\r\n", elapsed_ms);
+  } else if (mode == Ethernet::PhyMode::k10BaseT) {
+    SB_LOG_DEBUG(g_uart, kNET, "[PHY] Mode 10BASE-T, previous mode %u ms\r\n", elapsed_ms);
+  } else if (mode == Ethernet::PhyMode::kPowerDown) {
+    SB_LOG_DEBUG(g_uart, kNET, "[PHY] Mode power-down, previous mode %u ms\r\n", elapsed_ms);
+  } else {
+    SB_LOG_DEBUG(g_uart, kNET, "[PHY] Mode auto, previous mode %u ms\r\n", elapsed_ms);
+  }
+}
+
+bool mqtt_connect(const Config::SmartBellConfig& cfg) {
+  static MQTT::Config mqtt_cfg;
+  uint8_t broker_ip[4];
+  if (!broker_address(cfg, broker_ip)) {
+    return false;  // Hostname noch nie aufgelöst
+  }
+  fill_mqtt_config(cfg, broker_ip, mqtt_cfg);
+  if (!g_mqtt_client->connect(mqtt_cfg)) {
+#ifdef ENABLE_DNS
+    // Broker evtl. umgezogen: Adresse im Hintergrund neu auflösen
+    g_dns->refresh();
+#endif
+    return false;
+  }
+  g_mqtt_clean_pending = false;
+
+  // Ausfallzeit: Link-Down erkannt bis MQTT wieder verbunden
+  if (g_link->mark_recovered(System::TimerService::millis())) {
+    SB_LOG_INFO(g_uart, kNET, "[NET] Recovered after %u ms\r\n", g_link->last_recovery_ms());
+  }
+  return true;
+}
+
+// Link weg: Sockets sofort schließen statt 90 s auf den Keepalive zu warten
+void on_link_down() {
+  SB_LOG_WARN(g_uart, kNET, "[NET] Link down\r\n");
+  g_mqtt_client->abort();
+#ifdef ENABLE_TCP_CONSOLE
+  g_tcp_console->drop_client();
+#endif
+}
+
+// Link zurück: ohne die 5 s Reconnect-Pause neu verbinden
+void on_link_up(bool mqtt_configured) {
+  SB_LOG_INFO(g_uart, kNET, "[NET] Link up\r\n");
+#ifdef ENABLE_DHCP
+  if (g_dhcp != nullptr) {
+    // Evtl. anderes Netz: Lease per INIT-REBOOT bestätigen, MQTT folgt nach dem ACK
+    g_dhcp->init(g_config->config().mac);
+    return;
+  }
+#endif
+  if (mqtt_configured && !g_mqtt_client->is_connected()) {
+    mqtt_connect(g_config->config());
+  }
+}
+
+#ifdef ENABLE_PHY_SLEEP
+// So lange nach der letzten MQTT-Aktivität wach bleiben (Befehle vom Broker, PUBACK)
+static constexpr uint32_t kPhyIdleBeforeSleepMs = 2000;
+
+// PHY nur bei stehender MQTT-Session ohne offene Nachrichten abschalten und
+// vor dem nächsten PINGREQ um die gemessene Link-Up-Zeit früher aufwecken.
+// Nachrichten vom Broker kommen in der Schlafphase per TCP-Retransmission nach.
+void run_phy_sleep(uint32_t now) {
+  static uint32_t last_busy_ms = 0;
+  uint32_t next_ping_ms = g_mqtt_client->next_ping_in_ms();
+  if (g_phy->is_asleep()) {
+    if (next_ping_ms <= g_phy->wake_lead_ms()) {
+      g_phy->wake(now);
+    }
+    return;
+  }
+  if (!g_phy->is_ready() || !g_mqtt_client->is_idle() || chime1.is_ringing ||
+      chime2.is_ringing) {
+    last_busy_ms = now;
+    return;
+  }
+  if ((now - last_busy_ms) < kPhyIdleBeforeSleepMs ||
+      next_ping_ms <= g_phy->wake_lead_ms() + kPhyIdleBeforeSleepMs) {
+    return;  // Lohnt sich nicht mehr
+  }
+  g_phy->sleep(now);
 }
+#endif
 
 void process_chime(ChimeState& chime) {
   uint32_t now = System::TimerService::millis();
@@ -169,9 +522,18 @@ void process_chime(ChimeState& chime) {
       // seit letztem Event vergangen sind
       if (!chime.button_pressed && (now - chime.last_event_ms > 3000)) {
         chime.last_event_ms = now;  // Zeitstempel für den Cooldown setzen
+        chime.event_sequence = System::EventSequence::next();
         chime.button_pressed = true;
         chime.mqtt_sent = false;
         chime.trigger_pending = true;
+#ifdef ENABLE_PHY_SLEEP
+        // Event geht nach dem Link-Up aus der Queue raus
+        g_phy->wake(now);
+#endif
+#ifdef ENABLE_RING_GROUP
+        // Direkt an die Gruppe, unabhängig vom Broker
+        g_ring_group->send_ring((&chime == &chime1) ? 0x01 : 0x02);
+#endif
       }
     } else {
       // Taster losgelassen: Sofort zurücksetzen, unabhängig vom Gong!
@@ -194,17 +556,91 @@ void process_chime(ChimeState& chime) {
     if ((now - chime.ring_start_ms) >= 1500) {
       chime.is_ringing = false;
       *chime.out_port &= ~chime.out_pin;
-      print_log_ptr(g_uart, PSTR("[BELL] Ring ended\r\n"));
+      SB_LOG_DEBUG(g_uart, kBELL, "[BELL] Ring ended\r\n");
+    }
+  }
+
+  // 5. MQTT Event senden (Retry bis kEventRetryWindowMs nach dem Tastendruck,
+  // auch wenn der Taster schon losgelassen ist)
+  // Ring-Priorität in der Sende-Queue, QoS 1: der Client wiederholt bis zum
+  // PUBACK, auch über einen Reconnect hinweg. Payload ist der Event-Envelope
+  // (Boot-ID, Sequenz, Alter), Empfänger verwerfen Duplikate anhand der Sequenz.
+  if (chime.event_sequence == 0 || chime.mqtt_sent ||
+      (now - chime.last_event_ms) > kEventRetryWindowMs) {
+    return;
+  }
+  uint8_t payload[System::kEventEnvelopeLength];
+  System::encode_event(
+      System::EventSequence::envelope(chime.event_sequence, now - chime.last_event_ms), payload);
+
+  if (g_mqtt_client->is_connected() && chime.pub_topic) {
+    if (g_mqtt_client->queue_publish(chime.pub_packet, payload, MQTT::Priority::kRing,
+                                     MQTT::QoS::kAtLeastOnce)) {
+      chime.mqtt_sent = true;
+      SB_LOG_DEBUG(g_uart, kMQTT, "[MQTT] Queued button event\r\n");
     }
   }
 
-  // 5. MQTT Event senden (Retry solange gedrückt)
-  if (chime.button_pressed && !chime.mqtt_sent && g_mqtt_client->is_connected() &&
-      chime.pub_topic) {
-    static const char* payload = "1";
-    if (g_mqtt_client->publish(chime.pub_topic, reinterpret_cast<const uint8_t*>(payload), 1)) {
+#ifdef ENABLE_MQTT_SN
+  // Ohne TCP-Session (Boot, Broker-Hänger): ein einzelnes QoS -1 Datagramm an
+  // das MQTT-SN Gateway, ohne Verbindungsaufbau
+  if (!g_mqtt_client->is_connected()) {
+    uint16_t topic_id = (&chime == &chime1) ? kSnTopicChime1 : kSnTopicChime2;
+    if (g_mqtt_sn->publish(topic_id, payload, sizeof(payload))) {
       chime.mqtt_sent = true;
-      print_log_ptr(g_uart, PSTR("[MQTT] Published button event\r\n"));
+      SB_LOG_DEBUG(g_uart, kMQTT, "[MQTT-SN] Sent button event\r\n");
+    }
+  }
+#endif
+}
+
+// Zeileneditor für UART und TCP-Konsole. Beide teilen sich cmd_buffer: eine
+// angefangene Zeile gehört ihrer Quelle, die andere wird erst nach dem
+// Zeilenende weitergelesen (die Bytes warten solange im UART- bzw. W5500-Puffer).
+serial::Interface* g_cmd_owner = nullptr;
+
+void process_console_input(serial::Interface& input, bool echo) {
+  while ((g_cmd_owner == nullptr || g_cmd_owner == &input) && input.is_read_data_available()) {
+    char c = input.read_byte();
+    if (c == '\r' || c == '\n') {
+      if (cmd_index > 0) {
+        cmd_buffer[cmd_index] = '\0';
+        if (echo) {
+          print_log_ptr(g_uart, PSTR("\r\n"));
+        }
+        bool handled = process_socket_command(cmd_buffer, input);
+        handled = handled || System::process_log_command(cmd_buffer, input);
+        handled = handled || System::process_mem_command(cmd_buffer, input);
+#ifdef ENABLE_RING_GROUP
+        handled = handled || g_ring_group->process_command(cmd_buffer);
+#endif
+#ifdef ENABLE_DNS
+        handled = handled || g_dns->process_command(cmd_buffer);
+#endif
+        if (!handled) {
+          g_config->process_command(cmd_buffer);
+        }
+        prepare_chime_packets();
+        cmd_index = 0;
+        g_cmd_owner = nullptr;
+      }
+    } else if (c == '\b' || c == 0x7F) {
+      if (cmd_index > 0) {
+        cmd_index--;
+        if (echo) {
+          print_log_ptr(g_uart, PSTR("\b \b"));
+        }
+      }
+      if (cmd_index == 0) {
+        g_cmd_owner = nullptr;
+      }
+    } else if (cmd_index < sizeof(cmd_buffer) - 1) {
+      g_cmd_owner = &input;
+      cmd_buffer[cmd_index++] = c;
+      if (echo) {
+        char echo_text[2] = {c, '\0'};
+        g_uart->send_string(echo_text);
+      }
     }
   }
 }
@@ -231,10 +667,12 @@ void setup_GPIO() {
 }
 
 int main() {
-  uint8_t reset_cause = MCUSR;
-  MCUSR = 0;
+  uint8_t reset_cause = g_reset_flags;
   wdt_disable();
 
+  // Sequenz läuft über Watchdog-Resets weiter, neue Boot-ID nur nach Power-On/Brown-Out
+  System::EventSequence::init((reset_cause & ((1 << PORF) | (1 << BORF))) != 0);
+
   setup_GPIO();
 
   serial::Serial_parameters uart_params = {serial::Communication_mode::kAsynchronous,
@@ -246,17 +684,27 @@ int main() {
   serial::UART uart(uart_params);
   g_uart = &uart;
 
-  print_log_ptr(g_uart, PSTR("\r\n=== Smart Bell Booting ===\r\n"));
+  SB_LOG_INFO(g_uart, kAPP, "\r\n=== Smart Bell Booting ===\r\n");
 
   timer_interrupt::ctc_mode::setup_timer0_1ms();
 
-  static Config::LightweightConfig config(uart);
+#ifdef ENABLE_TCP_CONSOLE
+  // Konsolen-Ausgabe geht an die UART und, falls verbunden, an den TCP-Client
+  static Network::TcpConsole tcp_console(uart);
+  g_tcp_console = &tcp_console;
+  serial::Interface& console = tcp_console;
+#else
+  serial::Interface& console = uart;
+#endif
+
+  static Config::LightweightConfig config(console);
   g_config = &config;
   config.load();
   const Config::SmartBellConfig& cfg = config.config();
 
   chime1.pub_topic = cfg.input1_topic;
   chime2.pub_topic = cfg.input2_topic;
+  prepare_chime_packets();
 
   serial::SPI_parameters spi_params = {
       serial::SPI_mode::kMaster, serial::SPI_data_order::kMsb_first,
@@ -306,31 +754,78 @@ int main() {
   memcpy(gateway.addr, cfg.gateway, 4);
   w5500.set_network_config(&mac, &ip, &subnet, &gateway);
 
+  // Vor dem LinkMonitor: 10BASE-T setzt den PHY zurück, der Link kommt erst danach
+  static Ethernet::PhyPower phy_power(kPhyProfile, on_phy_event);
+  g_phy = &phy_power;
+  g_phy->begin(System::TimerService::millis());
+
+  static Ethernet::LinkMonitor link_monitor;
+  g_link = &link_monitor;
+  g_link->begin(System::TimerService::millis());
+
+#ifdef ENABLE_DHCP
+  // IP 0.0.0.0: Adresse per DHCP, gecachte Lease zuerst (ein Round-Trip)
+  if ((cfg.device_ip[0] | cfg.device_ip[1] | cfg.device_ip[2] | cfg.device_ip[3]) == 0) {
+    static SmartBell::DHCPClient dhcp_instance(&w5500, &uart);
+    g_dhcp = &dhcp_instance;
+    g_dhcp->init(cfg.mac);
+  }
+#endif
+
+#ifdef ENABLE_DNS
+  // DNS-Server: vom DHCP, sonst das Gateway (Router mit DNS-Forwarder)
+  static SmartBell::DNSClient dns_instance(&console);
+  g_dns = &dns_instance;
+  g_dns->begin();
+  g_dns->set_dns_server(cfg.gateway);
+#endif
+
+#ifdef ENABLE_TCP_CONSOLE
+  if (g_tcp_console->begin()) {
+    SB_LOG_INFO(g_uart, kNET, "[NET] TCP console on port 23\r\n");
+  }
+#endif
+
   static MQTT::MinimalMQTT mqtt_client_instance{&uart};
   g_mqtt_client = &mqtt_client_instance;
-
-  MQTT::Config mqtt_config;
-  memcpy(mqtt_config.broker_ip, cfg.broker_ip, 4);
-  mqtt_config.broker_port = cfg.broker_port;
-  strncpy(mqtt_config.client_id, cfg.client_id, MQTT::kMaxClientIdLength);
-  mqtt_config.client_id[MQTT::kMaxClientIdLength - 1] = '\0';
-  mqtt_config.use_auth = false;
-  mqtt_config.keepalive = 60;
-
-  bool mqtt_configured =
-      (cfg.broker_ip[0] | cfg.broker_ip[1] | cfg.broker_ip[2] | cfg.broker_ip[3]) != 0;
-  if (mqtt_configured) {
-    if (mqtt_client_instance.connect(mqtt_config)) {
-      mqtt_subscribe_topics(cfg);
-    }
+  mqtt_register_topics(cfg);
+
+#ifdef ENABLE_MQTT_SN
+  static MQTT::MinimalMQTTSN mqtt_sn_instance{&uart};
+  g_mqtt_sn = &mqtt_sn_instance;
+#endif
+
+#ifdef ENABLE_RING_GROUP
+  static Network::RingGroupNode ring_group_instance{console};
+  g_ring_group = &ring_group_instance;
+  if (g_ring_group->begin(cfg.mac, on_group_ring)) {
+    SB_LOG_INFO(g_uart, kNET, "[RING] Joined ring group\r\n");
+  }
+#endif
+
+  uint8_t broker_ip[4];
+  bool mqtt_configured = broker_address(cfg, broker_ip);
+#ifdef ENABLE_DNS
+  mqtt_configured = mqtt_configured || g_dns->has_hostname();
+#endif
+  if (mqtt_configured && network_up()) {
+#ifdef ENABLE_MQTT_SN
+    // Vor dem TCP-Connect: Events gehen so schon während des Handshakes raus
+    g_mqtt_sn->begin(broker_ip);
+#endif
+    mqtt_connect(cfg);
   }
 
-  print_log_ptr(g_uart, PSTR("[SYS] App Engine fully operational!\r\n\r\n"));
+  SB_LOG_INFO(g_uart, kAPP, "[SYS] App Engine fully operational!\r\n\r\n");
   wdt_enable(WDTO_4S);
   sei();
 
   uint32_t last_millis = 0;
   uint32_t last_mqtt_retry_ms = 0;
+  // poll() löscht RECV auch für Sockets, deren Client gerade nicht läuft. Der
+  // erste Lauf nach so einer Pause liest daher den RX-Puffer ohne Event
+  [[maybe_unused]] bool dhcp_was_run = false;
+  [[maybe_unused]] bool dns_was_run = false;
 
   init_chime(chime1);
   init_chime(chime2);
@@ -340,45 +835,106 @@ int main() {
 
   while (1) {
     wdt_reset();
-    g_mqtt_client->loop();
+    uint32_t loop_ms = System::TimerService::millis();
+#ifdef ENABLE_PHY_SLEEP
+    run_phy_sleep(loop_ms);
+#endif
+    // PHY aus oder noch nicht wieder da: geplanter Link-Verlust, kein Ausfall
+    Ethernet::LinkEvent link_event =
+        g_phy->run(loop_ms) ? g_link->run(loop_ms) : Ethernet::LinkEvent::kNone;
+    switch (link_event) {
+      case Ethernet::LinkEvent::kDown:
+        on_link_down();
+        break;
+      case Ethernet::LinkEvent::kUp:
+        on_link_up(mqtt_configured);
+        last_mqtt_retry_ms = System::TimerService::millis();
+        break;
+      default:
+        break;
+    }
+
+    // Ein SIR-Byte über SPI statt einer RX_RSR-Abfrage pro Socket
+    [[maybe_unused]] uint8_t ready_sockets =
+        (kPolledSockets != 0) ? Ethernet::EmbeddedSocketW5500::poll(kPolledSockets, nullptr) : 0;
+#ifdef ENABLE_DHCP
+    if (g_dhcp != nullptr && g_phy->is_ready()) {
+      bool dhcp_rx =
+          !dhcp_was_run || (ready_sockets & (1 << SmartBell::DHCPClient::kDHCPSocket)) != 0;
+      dhcp_was_run = true;
+      SmartBell::DHCPStatus dhcp_status = g_dhcp->run(dhcp_rx);
+      if (dhcp_status == SmartBell::DHCPStatus::kIPAssign ||
+          dhcp_status == SmartBell::DHCPStatus::kIPChanged) {
+        // Neue Adresse: eine bestehende TCP-Session ist damit ungültig
+        g_dhcp->apply_config();
+#ifdef ENABLE_DNS
+        uint8_t dns_server[4];
+        g_dhcp->get_dns(dns_server);
+        if ((dns_server[0] | dns_server[1] | dns_server[2] | dns_server[3]) == 0) {
+          g_dhcp->get_gateway(dns_server);
+        }
+        g_dns->set_dns_server(dns_server);
+#endif
+        g_mqtt_client->disconnect();
+        if (mqtt_configured) {
+          mqtt_connect(g_config->config());
+        }
+      } else if (dhcp_status == SmartBell::DHCPStatus::kFailed) {
+        g_mqtt_client->disconnect();
+      }
+    } else {
+      dhcp_was_run = false;
+    }
+#endif
+#ifdef ENABLE_DNS
+    bool dns_rx = !dns_was_run || (ready_sockets & (1 << SmartBell::DNSClient::kDNSSocket)) != 0;
+    dns_was_run = network_up();
+    if (dns_was_run && g_dns->run(dns_rx)) {
+      // Erste oder geänderte Broker-Adresse
+      mqtt_configured = true;
+      g_mqtt_client->disconnect();
+#ifdef ENABLE_MQTT_SN
+      g_dns->get_ip(broker_ip);
+      g_mqtt_sn->begin(broker_ip);
+#endif
+      mqtt_connect(g_config->config());
+    }
+#endif
+    if (g_phy->is_ready()) {
+      g_mqtt_client->loop();
+    }
+#ifdef ENABLE_MQTT_SN
+    g_mqtt_sn->loop();
+#endif
+#ifdef ENABLE_RING_GROUP
+    if (ready_sockets & (1 << Network::RingGroupNode::kSocketNumber)) {
+      g_ring_group->loop();
+    }
+#endif
 
-    if (mqtt_configured && !g_mqtt_client->is_connected()) {
+    if (mqtt_configured && network_up() && !g_mqtt_client->is_connected()) {
       uint32_t now = System::TimerService::millis();
       if ((now - last_mqtt_retry_ms) >= 5000) {
         last_mqtt_retry_ms = now;
-        const Config::SmartBellConfig& live_cfg = g_config->config();
-
-        static MQTT::Config retry_cfg;
-        memcpy(retry_cfg.broker_ip, live_cfg.broker_ip, 4);
-        retry_cfg.broker_port = live_cfg.broker_port;
-        strncpy(retry_cfg.client_id, live_cfg.client_id, MQTT::kMaxClientIdLength);
-        retry_cfg.client_id[MQTT::kMaxClientIdLength - 1] = '\0';
-        retry_cfg.use_auth = false;
-        retry_cfg.keepalive = 60;
-
-        print_log_ptr(g_uart, PSTR("[MQTT] Reconnect...\r\n"));
-        if (g_mqtt_client->connect(retry_cfg)) {
-          mqtt_subscribe_topics(live_cfg);
-        }
+        SB_LOG_INFO(g_uart, kMQTT, "[MQTT] Reconnect...\r\n");
+        mqtt_connect(g_config->config());
       }
     }
 
     if (g_config->consume_save_flag()) {
       const Config::SmartBellConfig& live_cfg = g_config->config();
-      bool has_broker = (live_cfg.broker_ip[0] | live_cfg.broker_ip[1] | live_cfg.broker_ip[2] |
-                         live_cfg.broker_ip[3]) != 0;
+      bool has_broker = broker_address(live_cfg, broker_ip);
       mqtt_configured = has_broker;
-      if (has_broker) {
-        static MQTT::Config reconnect_cfg;
-        memcpy(reconnect_cfg.broker_ip, live_cfg.broker_ip, 4);
-        reconnect_cfg.broker_port = live_cfg.broker_port;
-        strncpy(reconnect_cfg.client_id, live_cfg.client_id, MQTT::kMaxClientIdLength);
-        reconnect_cfg.client_id[MQTT::kMaxClientIdLength - 1] = '\0';
-        reconnect_cfg.use_auth = false;
-        reconnect_cfg.keepalive = 60;
-        if (g_mqtt_client->connect(reconnect_cfg)) {
-          mqtt_subscribe_topics(live_cfg);
-        }
+#ifdef ENABLE_DNS
+      mqtt_configured = mqtt_configured || g_dns->has_hostname();
+#endif
+      mqtt_register_topics(live_cfg);
+      g_mqtt_clean_pending = true;
+      if (has_broker && network_up()) {
+#ifdef ENABLE_MQTT_SN
+        g_mqtt_sn->begin(broker_ip);
+#endif
+        mqtt_connect(live_cfg);
       }
     }
 
@@ -386,31 +942,17 @@ int main() {
     process_chime(chime1);
     process_chime(chime2);
 
-    // UART Parser
-    while (uart.is_read_data_available()) {
-      char c = uart.read_byte();
-      if (c == '\r' || c == '\n') {
-        if (cmd_index > 0) {
-          cmd_buffer[cmd_index] = '\0';
-          print_log_ptr(g_uart, PSTR("\r\n"));
-          g_config->process_command(cmd_buffer);
-          cmd_index = 0;
-        }
-      } else if (c == '\b' || c == 0x7F) {
-        if (cmd_index > 0) {
-          cmd_index--;
-          print_log_ptr(g_uart, PSTR("\b \b"));
-        }
-      } else if (cmd_index < 31) {
-        cmd_buffer[cmd_index++] = c;
-        char echo[2] = {c, '\0'};
-        uart.send_string(echo);
-      }
-    }
+    // Konsolen-Parser
+    process_console_input(uart, true);
+#ifdef ENABLE_TCP_CONSOLE
+    g_tcp_console->loop();
+    process_console_input(*g_tcp_console, false);
+#endif
 
     uint32_t current_millis = System::TimerService::millis();
     if (current_millis - last_millis > 100) {
       last_millis = current_millis;
+      g_w5500->sample_buffers();
       _delay_ms(10);
     }
   }
@@ -1,4 +1,5 @@
 set(OBJCOPY /opt/avr8-gnu-toolchain-linux_x86_64/bin/avr-objcopy)
+set(AVR_SIZE /opt/avr8-gnu-toolchain-linux_x86_64/bin/avr-size)
 
 function(run_bin2hex)
     cmake_parse_arguments(
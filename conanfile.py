@@ -36,7 +36,7 @@ class Atmega328TemplateRecipe(ConanFile):
         "examples": False  
     }
     ioLibrary_Driver_Version = "v3.2.0"
-    exports_sources = "CMakeLists.txt", "*.cmake", "app/*", "src/*", "public/*", "private/*", "tests/*", "style/*", "docs/Doxyfile", "configure/*", ".github/workflows/*", "cmake/*",".gitignore", "LICENSE", "README.md", "requirements.txt", "conanfile.py"
+    exports_sources = "CMakeLists.txt", "*.cmake", "app/*", "src/*", "public/*", "private/*", "tests/*", "style/*", "docs/Doxyfile", "configure/*", ".github/workflows/*", "cmake/*", "tools/*", ".gitignore", "LICENSE", "README.md", "requirements.txt", "conanfile.py"
     
     def build_requirements(self):
         self.tool_requires("cmake/3.27.7")
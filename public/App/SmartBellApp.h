@@ -9,10 +9,12 @@
 #include "MQTT/MinimalMQTT.h"
 #include "Serial/Interface.h"
 #include "SetupEXT_IN_Interrupt.h"
+#include "System/LogFilter.h"
 
-// Define to disable verbose logging (saves ~2-3KB flash)
+// State transitions, topics and payloads are only built in with APP at debug
+// level (SB_LOG_LEVEL_APP=4, saves ~2-3KB flash otherwise)
 #ifndef SMARTBELL_VERBOSE_LOG
-#define SMARTBELL_VERBOSE_LOG 0
+#define SMARTBELL_VERBOSE_LOG (SB_LOG_LEVEL_APP >= 4)
 #endif
 
 namespace App {
@@ -46,30 +48,38 @@ enum class ButtonId : uint8_t {
 
 /**
  * @brief MQTT topics used by SmartBell.
+ * Arrays (not pointers) so the topic length is known at compile time, see
+ * MQTT::make_prepared_publish_P(). Kept in flash: read them with the _P
+ * functions or through Utils::as_flash().
  */
 struct SmartBellTopics {
   // Button event topics (publish)
-  static constexpr const char* kFrontdoorActive = "smartbell/bellbutton/frontdoor/active";
-  static constexpr const char* kFrontdoorInactive = "smartbell/bellbutton/frontdoor/inactive";
-  static constexpr const char* kOfficeActive = "smartbell/bellbutton/office/active";
-  static constexpr const char* kOfficeInactive = "smartbell/bellbutton/office/inactive";
+  static constexpr char kFrontdoorActive[] PROGMEM = "smartbell/bellbutton/frontdoor/active";
+  static constexpr char kFrontdoorInactive[] PROGMEM = "smartbell/bellbutton/frontdoor/inactive";
+  static constexpr char kOfficeActive[] PROGMEM = "smartbell/bellbutton/office/active";
+  static constexpr char kOfficeInactive[] PROGMEM = "smartbell/bellbutton/office/inactive";
 
   // Gong status topics (subscribe)
-  static constexpr const char* kGongUpperfloorStatus = "smartbell/gong/upperfloor/status";
-  static constexpr const char* kGongGroundfloorStatus = "smartbell/gong/groundfloor/status";
+  static constexpr char kGongUpperfloorStatus[] PROGMEM = "smartbell/gong/upperfloor/status";
+  static constexpr char kGongGroundfloorStatus[] PROGMEM = "smartbell/gong/groundfloor/status";
 
   // Test gong topics (subscribe)
-  static constexpr const char* kTestGongUpperfloor = "smartbell/gong/upperfloor/testgong";
-  static constexpr const char* kTestGongGroundfloor = "smartbell/gong/groundfloor/testgong";
-  static constexpr const char* kTestGongBoth = "smartbell/gong/testgong";
+  static constexpr char kTestGongUpperfloor[] PROGMEM = "smartbell/gong/upperfloor/testgong";
+  static constexpr char kTestGongGroundfloor[] PROGMEM = "smartbell/gong/groundfloor/testgong";
+  static constexpr char kTestGongBoth[] PROGMEM = "smartbell/gong/testgong";
 
   // Configuration topics (subscribe)
-  static constexpr const char* kGongDuration = "smartbell/gong/duration";
+  static constexpr char kGongDuration[] PROGMEM = "smartbell/gong/duration";
 
-  // Legacy topics
-  static constexpr const char* kStatus = "smartbell/status";
+  // Filter covering all gong control topics above
+  static constexpr char kGongControlFilter[] PROGMEM = "smartbell/gong/#";
+
+  // Presence (retained, Last Will / birth message). Stays in SRAM: referenced
+  // by MQTT::Config::will_topic
+  static constexpr char kStatus[] = "smartbell/status";
 };
 
+
 /**
  * @brief SmartBell main application class.
  *
@@ -43,6 +43,9 @@ class LightweightConfig {
   // Command processing
   bool process_command(const char* command);
 
+  // Command processing with the output going to @p output instead of the UART
+  bool process_command(const char* command, serial::Interface& output);
+
   // Config access/storage
   void load();
   void save();
@@ -55,6 +55,10 @@ enum class W5500SocketState : uint16_t {
   kSOCK_LAST_ACK = 0x1D
 };
 
+// Socket events reported by EmbeddedSocketW5500::poll() (Sn_IR bits). SENDOK
+// is masked out: socket.c send() waits for it and clears it itself
+constexpr uint8_t kPollEvents = Sn_IR_CON | Sn_IR_DISCON | Sn_IR_RECV | Sn_IR_TIMEOUT;
+
 struct W5500SocketStatus {
   W5500SocketNumber socket_number;    // Socket number
   W5500SocketProtocol protocol_type;  // Protocol type (TCP/UDP/IPRAW)
@@ -84,6 +88,24 @@ class EmbeddedSocketW5500 {
 
   W5500SocketStatus get_socket_status(uint8_t socket_num) const;
 
+  /**
+   * @brief Readiness check for several sockets at once.
+   *
+   * Reads SIR (one interrupt bit per socket) in a single SPI transaction and
+   * Sn_IR only for the sockets flagged there, so polling N idle sockets costs
+   * one register byte instead of N Sn_SR / Sn_RX_RSR reads.
+   * Events are edge triggered and cleared when reported: a socket shows up
+   * once per event, after RECV the caller has to drain its RX buffer. A socket
+   * whose reader is skipped in this pass loses the event, not the data: the
+   * next read has to check Sn_RX_RSR instead of waiting for RECV.
+   *
+   * @param mask Bit n: poll socket n. Enables the socket in SIMR on first use.
+   * @param events Optional (nullptr), 8 entries indexed by socket number; the
+   *        kPollEvents bits of every ready socket are written there.
+   * @return Ready bitmap (subset of @p mask).
+   */
+  static uint8_t poll(uint8_t mask, uint8_t* events);
+
  private:
   const Ethernet::W5500Interface* const w5500_interface_ = nullptr;
   W5500SocketStatus socket_status_[8];
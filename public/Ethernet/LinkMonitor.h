@@ -0,0 +1,73 @@
+#ifndef PUBLIC_ETHERNET_LINKMONITOR_H_
+#define PUBLIC_ETHERNET_LINKMONITOR_H_
+
+#include <stdint.h>
+
+namespace Ethernet {
+
+enum class LinkEvent : uint8_t {
+  kNone = 0,
+  kDown = 1,  // Cable unplugged / switch port down
+  kUp = 2     // Link back (or first link after boot)
+};
+
+/**
+ * @brief Low-rate PHY link watcher for the W5500.
+ *
+ * Reads PHYCFGR (one SPI register read) every kPollIntervalMs and reports
+ * link changes as events, so the app can drop its sockets right away instead
+ * of waiting for the MQTT keepalive, and reconnect as soon as the link is
+ * back. Also measures the outage: from the detected link-down until the app
+ * reports its services back with mark_recovered().
+ */
+class LinkMonitor {
+ public:
+  static constexpr uint16_t kPollIntervalMs = 250;
+
+  LinkMonitor();
+
+  /**
+   * @brief Read the initial link state. Needs an initialized W5500.
+   */
+  void begin(uint32_t now_ms);
+
+  /**
+   * @brief Check the link, at most every kPollIntervalMs.
+   * @param now_ms Current millis().
+   * @return Link change since the last check.
+   */
+  LinkEvent run(uint32_t now_ms);
+
+  bool is_up() const { return up_; }
+
+  /**
+   * @brief Report that the services are back (e.g. MQTT connected).
+   * @return true if this ends an outage; last_recovery_ms() is updated then.
+   */
+  bool mark_recovered(uint32_t now_ms);
+
+  /**
+   * @brief Duration of the last outage, link-down detected to recovered, in ms.
+   * 0 until the first recovery.
+   */
+  uint32_t last_recovery_ms() const { return last_recovery_ms_; }
+
+  /**
+   * @brief Number of link-down events since boot.
+   */
+  uint16_t link_down_count() const { return link_down_count_; }
+
+ private:
+  static bool read_link();
+
+  uint32_t last_poll_ms_;
+  uint32_t down_since_ms_;
+  uint32_t last_recovery_ms_;
+  uint16_t link_down_count_;
+  bool up_;
+  bool recovering_;  // Link went down, services not back yet
+};
+
+}  // namespace Ethernet
+
+#endif  // PUBLIC_ETHERNET_LINKMONITOR_H_
@@ -0,0 +1,117 @@
+#ifndef PUBLIC_ETHERNET_PHYPOWER_H_
+#define PUBLIC_ETHERNET_PHYPOWER_H_
+
+#include <stdint.h>
+
+namespace Ethernet {
+
+/**
+ * @brief PHY power profile, chosen at build time by the app.
+ */
+enum class PhyProfile : uint8_t {
+  kAutoNegotiation = 0,  // W5500 default: 10/100, half/full auto-negotiation
+  k10BaseT = 1,          // Forced 10BASE-T half duplex
+  k10BaseTSleep = 2      // 10BASE-T, PHY powered down while sleep() is in effect
+};
+
+enum class PhyMode : uint8_t {
+  kAutoNegotiation = 0,
+  k10BaseT = 1,
+  kPowerDown = 2
+};
+
+enum class PhyEvent : uint8_t {
+  kModeChanged = 0,  // elapsed_ms: time spent in the previous mode
+  kLinkUp = 1,       // elapsed_ms: mode change to first link (link-up latency)
+  kLinkTimeout = 2   // No link within kLinkTimeoutMs after the mode change
+};
+
+/**
+ * @brief Measurement hook, called from begin() / sleep() / wake() / run().
+ */
+using PhyHook = void (*)(PhyEvent event, PhyMode mode, uint32_t elapsed_ms);
+
+/**
+ * @brief PHY operation mode and power-down control for the W5500.
+ *
+ * 10BASE-T is forced as half duplex without auto-negotiation: a switch port
+ * that auto-negotiates detects a fixed 10 Mbit partner by parallel detection
+ * and runs half duplex, so forcing full duplex would cause a duplex mismatch.
+ *
+ * With k10BaseTSleep the app may power the PHY down between MQTT keepalives.
+ * The link drops while the PHY is down and takes a while to come back after
+ * wake(); is_ready() stays false until then, so the app neither sends nor
+ * reports the planned link loss as an outage. Every mode change and the time
+ * to the following link-up are reported through the hook.
+ */
+class PhyPower {
+ public:
+  /// Link-up latency measurement gives up after this
+  static constexpr uint16_t kLinkTimeoutMs = 5000;
+  /// PHYCFGR read interval while waiting for the link
+  static constexpr uint8_t kPollIntervalMs = 10;
+  /// Wake lead until a link-up latency was measured
+  static constexpr uint16_t kDefaultWakeLeadMs = 3000;
+  /// Added to the measured link-up latency for wake_lead_ms()
+  static constexpr uint16_t kWakeMarginMs = 500;
+
+  explicit PhyPower(PhyProfile profile, PhyHook hook = nullptr);
+
+  /**
+   * @brief Apply the profile (resets the PHY unless kAutoNegotiation) and
+   * measure the first link-up. Needs an initialized W5500.
+   */
+  void begin(uint32_t now_ms);
+
+  /**
+   * @brief Power the PHY down. Only with k10BaseTSleep, otherwise ignored.
+   */
+  void sleep(uint32_t now_ms);
+
+  /**
+   * @brief Power the PHY back up into 10BASE-T, no-op if awake.
+   */
+  void wake(uint32_t now_ms);
+
+  /**
+   * @brief Measure the link-up latency after a mode change.
+   * @return is_ready().
+   */
+  bool run(uint32_t now_ms);
+
+  /**
+   * @brief false while the PHY is down or waking up (link not back yet).
+   */
+  bool is_ready() const { return !asleep_ && !waking_; }
+
+  bool is_asleep() const { return asleep_; }
+
+  bool can_sleep() const { return profile_ == PhyProfile::k10BaseTSleep; }
+
+  /**
+   * @brief Last measured link-up latency in ms, 0 before the first link.
+   */
+  uint16_t last_link_up_ms() const { return last_link_up_ms_; }
+
+  /**
+   * @brief How long before a deadline (e.g. the next PINGREQ) to call wake().
+   */
+  uint16_t wake_lead_ms() const;
+
+ private:
+  void set_mode(PhyMode mode, uint32_t now_ms);
+
+  PhyHook hook_;
+  uint32_t mode_since_ms_;
+  uint32_t last_poll_ms_;
+  uint16_t last_link_up_ms_;
+  PhyProfile profile_;
+  PhyMode mode_;
+  bool measuring_;  // Mode changed, waiting for the link
+  bool asleep_;
+  bool waking_;  // wake() called, link not back yet
+};
+
+}  // namespace Ethernet
+
+#endif  // PUBLIC_ETHERNET_PHYPOWER_H_
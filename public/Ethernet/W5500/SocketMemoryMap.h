@@ -0,0 +1,118 @@
+#ifndef PUBLIC_ETHERNET_W5500_SOCKETMEMORYMAP_H_
+#define PUBLIC_ETHERNET_W5500_SOCKETMEMORYMAP_H_
+
+#include <stdint.h>
+
+namespace Ethernet {
+
+/**
+ * @brief Socket numbers by role. The modules keep their own constants
+ * (DHCPClient::kDHCPSocket, MinimalMQTT::kMQTTSocketNumber, ...), the app
+ * checks them against these with static_assert.
+ */
+enum SocketRole : uint8_t {
+  kSocketDHCP = 0,
+  kSocketDNS = 1,
+  kSocketMQTT = 2,
+  kSocketMQTTSN = 3,
+  kSocketRingGroup = 4,
+  kSocketConsole = 5
+};
+
+static constexpr uint8_t kSocketCount = 8;
+
+/// TX and RX memory of the W5500, each shared by all sockets
+static constexpr uint8_t kSocketMemoryTotalKb = 16;
+
+/**
+ * @brief TX/RX buffer size per socket in KB, passed to CW_INIT_WIZCHIP.
+ *
+ * MQTT gets the large RX window: the retained messages sent right after
+ * SUBSCRIBE arrive as one burst, and a full window stalls TCP until loop()
+ * drains it. DHCP gets room for two OFFERs. Sockets of features that are not
+ * built get no memory.
+ */
+struct SocketMemoryMap {
+  uint8_t tx_kb[kSocketCount];
+  uint8_t rx_kb[kSocketCount];
+};
+
+namespace socket_memory {
+
+#ifdef ENABLE_DHCP
+static constexpr uint8_t kDHCPTxKb = 1;
+static constexpr uint8_t kDHCPRxKb = 2;
+#else
+static constexpr uint8_t kDHCPTxKb = 0;
+static constexpr uint8_t kDHCPRxKb = 0;
+#endif
+
+#ifdef ENABLE_DNS
+static constexpr uint8_t kDNSKb = 1;
+#else
+static constexpr uint8_t kDNSKb = 0;
+#endif
+
+static constexpr uint8_t kMQTTTxKb = 4;
+static constexpr uint8_t kMQTTRxKb = 8;
+
+#ifdef ENABLE_MQTT_SN
+static constexpr uint8_t kMQTTSNKb = 1;
+#else
+static constexpr uint8_t kMQTTSNKb = 0;
+#endif
+
+#ifdef ENABLE_RING_GROUP
+static constexpr uint8_t kRingGroupKb = 1;
+#else
+static constexpr uint8_t kRingGroupKb = 0;
+#endif
+
+#ifdef ENABLE_TCP_CONSOLE
+static constexpr uint8_t kConsoleTxKb = 2;  // "show" / "help" output in one go
+static constexpr uint8_t kConsoleRxKb = 1;
+#else
+static constexpr uint8_t kConsoleTxKb = 0;
+static constexpr uint8_t kConsoleRxKb = 0;
+#endif
+
+constexpr bool is_valid_size(uint8_t kb) {
+  return kb == 0 || kb == 1 || kb == 2 || kb == 4 || kb == 8 || kb == 16;
+}
+
+constexpr uint16_t total_kb(const uint8_t* kb) {
+  uint16_t total = 0;
+  for (uint8_t i = 0; i < kSocketCount; i++) {
+    total += kb[i];
+  }
+  return total;
+}
+
+constexpr bool all_valid(const uint8_t* kb) {
+  for (uint8_t i = 0; i < kSocketCount; i++) {
+    if (!is_valid_size(kb[i])) {
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace socket_memory
+
+static constexpr SocketMemoryMap kSocketMemoryMap = {
+    {socket_memory::kDHCPTxKb, socket_memory::kDNSKb, socket_memory::kMQTTTxKb,
+     socket_memory::kMQTTSNKb, socket_memory::kRingGroupKb, socket_memory::kConsoleTxKb, 0, 0},
+    {socket_memory::kDHCPRxKb, socket_memory::kDNSKb, socket_memory::kMQTTRxKb,
+     socket_memory::kMQTTSNKb, socket_memory::kRingGroupKb, socket_memory::kConsoleRxKb, 0, 0}};
+
+static_assert(socket_memory::total_kb(kSocketMemoryMap.tx_kb) <= kSocketMemoryTotalKb,
+              "W5500 TX memory exceeds 16 KB");
+static_assert(socket_memory::total_kb(kSocketMemoryMap.rx_kb) <= kSocketMemoryTotalKb,
+              "W5500 RX memory exceeds 16 KB");
+static_assert(socket_memory::all_valid(kSocketMemoryMap.tx_kb) &&
+                  socket_memory::all_valid(kSocketMemoryMap.rx_kb),
+              "W5500 socket memory must be 0, 1, 2, 4, 8 or 16 KB");
+
+}  // namespace Ethernet
+
+#endif  // PUBLIC_ETHERNET_W5500_SOCKETMEMORYMAP_H_
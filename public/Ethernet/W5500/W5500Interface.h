@@ -4,6 +4,7 @@
 #include <Serial/SPI.h>
 #include <Serial/UART.h>
 
+#include "Ethernet/W5500/SocketMemoryMap.h"
 #include "Ethernet/wizchip_conf.h"
 
 namespace Ethernet {
@@ -21,6 +22,16 @@ struct GatewayAddress {
   uint8_t addr[4];
 };
 
+/**
+ * @brief Bytes in a socket's TX/RX buffer, now and the maximum seen.
+ */
+struct SocketBufferUse {
+  uint16_t tx_used;  // Not yet sent or not yet ACKed
+  uint16_t rx_used;  // Received, not yet read
+  uint16_t tx_high;
+  uint16_t rx_high;
+};
+
 struct W5500Callbacks {
   void (*hard_reset)() = nullptr;
   void (*chip_select)() = nullptr;
@@ -54,11 +65,25 @@ class W5500Interface
   void get_subnet(SubnetMask* subnet) const;
   void get_gateway(GatewayAddress* gateway) const;
 
+  /**
+   * @brief Update the high-water marks of all sockets that have memory.
+   * Two register reads per socket, call it periodically from the main loop.
+   */
+  void sample_buffers();
+
+  /**
+   * @brief Current use and high-water mark of a socket's buffers.
+   * Sizes are in kSocketMemoryMap.
+   */
+  SocketBufferUse buffer_use(uint8_t socket) const;
+
  private:
   serial::SPI *const spi_ = nullptr;
   serial::UART *const uart_log_ = nullptr;
   static wiz_NetInfo netInfo_;
   bool initialized_;
+  uint16_t tx_high_[kSocketCount];
+  uint16_t rx_high_[kSocketCount];
 
   static uint8_t cb_spi_read();
   static void cb_spi_write(uint8_t data);
@@ -229,7 +229,7 @@ typedef uint16_t iodata_t;
 #endif
 
 #if _WIZCHIP_ >= W5200
-#define _WIZCHIP_SOCK_NUM_ 2  ///< The count of independant socket of @b WIZCHIP
+#define _WIZCHIP_SOCK_NUM_ 8  ///< The count of independant socket of @b WIZCHIP
 #else
 #define _WIZCHIP_SOCK_NUM_ 4  ///< The count of independant socket of @b WIZCHIP
 #endif
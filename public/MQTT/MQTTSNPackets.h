@@ -0,0 +1,84 @@
+#ifndef PUBLIC_MQTT_MQTTSNPACKETS_H_
+#define PUBLIC_MQTT_MQTTSNPACKETS_H_
+
+#include <stdint.h>
+#include <string.h>
+
+namespace MQTT {
+namespace SN {
+
+// MQTT-SN 1.2 Protocol Constants
+constexpr uint8_t kProtocolId = 0x01;
+constexpr uint16_t kDefaultGatewayPort = 10000;  // Eclipse Paho MQTT-SN gateway
+
+// MQTT-SN Message Types
+enum class MessageType : uint8_t {
+  CONNECT = 0x04,
+  CONNACK = 0x05,
+  PUBLISH = 0x0C,
+  PINGREQ = 0x16,
+  PINGRESP = 0x17,
+  DISCONNECT = 0x18
+};
+
+// Flags field
+constexpr uint8_t kFlagCleanSession = 0x04;
+constexpr uint8_t kTopicIdPredefined = 0x01;  // Topic id registered at the gateway
+
+// QoS bits of the flags field. kMinusOne needs no connection to the gateway.
+enum class QoS : uint8_t { kAtMostOnce = 0x00, kMinusOne = 0x60 };
+
+// Length(1) + type(1) + flags(1) + topic id(2) + msg id(2)
+constexpr uint8_t kPublishHeaderLength = 7;
+
+// Length(1) + type(1) + flags(1) + protocol id(1) + duration(2)
+constexpr uint8_t kConnectHeaderLength = 6;
+
+/**
+ * @brief Build a PUBLISH to a pre-registered topic id.
+ * @return Packet length, 0 if it does not fit @p capacity.
+ */
+inline uint8_t build_publish(uint8_t* buffer, uint8_t capacity, uint16_t topic_id, QoS qos,
+                             const uint8_t* payload, uint8_t length) {
+  uint8_t total = kPublishHeaderLength + length;
+  if (length > capacity || total > capacity) {
+    return 0;
+  }
+
+  buffer[0] = total;
+  buffer[1] = static_cast<uint8_t>(MessageType::PUBLISH);
+  buffer[2] = static_cast<uint8_t>(qos) | kTopicIdPredefined;
+  buffer[3] = (topic_id >> 8) & 0xFF;
+  buffer[4] = topic_id & 0xFF;
+  buffer[5] = 0;  // Msg id is only used for QoS 1/2
+  buffer[6] = 0;
+  memcpy(&buffer[kPublishHeaderLength], payload, length);
+  return total;
+}
+
+/**
+ * @brief Build a CONNECT (clean session).
+ * @return Packet length, 0 if it does not fit @p capacity.
+ */
+inline uint8_t build_connect(uint8_t* buffer, uint8_t capacity, const char* client_id,
+                             uint16_t duration) {
+  size_t id_length = strlen(client_id);
+  if (id_length > capacity || kConnectHeaderLength + id_length > capacity) {
+    return 0;
+  }
+  uint8_t total = static_cast<uint8_t>(kConnectHeaderLength + id_length);
+
+  buffer[0] = total;
+  buffer[1] = static_cast<uint8_t>(MessageType::CONNECT);
+  buffer[2] = kFlagCleanSession;
+  buffer[3] = kProtocolId;
+  buffer[4] = (duration >> 8) & 0xFF;
+  buffer[5] = duration & 0xFF;
+  memcpy(&buffer[kConnectHeaderLength], client_id, id_length);
+  return total;
+}
+
+}  // namespace SN
+}  // namespace MQTT
+
+#endif  // PUBLIC_MQTT_MQTTSNPACKETS_H_
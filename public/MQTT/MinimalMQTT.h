@@ -2,34 +2,76 @@
 #define PUBLIC_MQTT_MINIMALMQTT_H_
 
 #include <stdint.h>
+#include "MQTT/PacketFramer.h"
+#include "MQTT/PacketTemplates.h"
+#include "MQTT/RttEstimator.h"
+#include "MQTT/TopicFilter.h"
 #include "Serial/UART.h"
+#include "Utils/FlashString.h"
 
 namespace MQTT {
 
 // MQTT Protocol Constants
-constexpr uint8_t kMQTTProtocolLevel = 4;   // MQTT 3.1.1
 constexpr uint16_t kDefaultKeepalive = 60;  // seconds
 
 // Buffer sizes - optimized for ATmega328P
 constexpr uint16_t kSendBufferSize = 64;
 constexpr uint16_t kRecvBufferSize = 64;
-constexpr uint8_t kMaxTopicLength = 32;
+constexpr uint8_t kMaxTopicLength = 40;  // Received topic copy, longest SmartBell topic is 39
 constexpr uint8_t kMaxClientIdLength = 24;
 constexpr uint8_t kMaxUsernameLength = 24;
 constexpr uint8_t kMaxPasswordLength = 24;
+constexpr uint8_t kMaxWillPayloadLength = 16;
+
+// Presence payloads in flash, for Config::will_payload / birth_payload with
+// Config::presence_in_flash
+constexpr char kPresenceOnline[] PROGMEM = "online";
+constexpr char kPresenceOffline[] PROGMEM = "offline";
 constexpr uint8_t kMaxSubscriptions = 2;
+static_assert(kMaxSubscriptions <= 8, "Subscription slots are tracked in a uint8_t mask");
 
-// MQTT Message Types
-enum class MessageType : uint8_t {
-  CONNECT = 0x10,
-  CONNACK = 0x20,
-  PUBLISH = 0x30,
-  SUBSCRIBE = 0x82,
-  SUBACK = 0x90,
-  PINGREQ = 0xC0,
-  PINGRESP = 0xD0,
-  DISCONNECT = 0xE0
-};
+// CONNACK acknowledge flags (byte 1 of variable header)
+constexpr uint8_t kConnackSessionPresent = 0x01;
+
+// SUBACK return code for a rejected topic filter
+constexpr uint8_t kSubackFailure = 0x80;
+
+// Upper bound for the TCP handshake and the CONNACK wait. The actual waits
+// follow the retransmission timers (see Config::retry_time_ms)
+constexpr uint16_t kConnackTimeoutMs = 5000;
+
+// W5500 retransmissions (RCR) before a segment times out, if not configured
+constexpr uint8_t kDefaultRetryCount = 3;
+
+// Max time loop() spends draining received packets before returning
+constexpr uint8_t kRecvBudgetMs = 10;
+
+// QoS 1 in-flight window - fixed at compile time, costs 18 bytes per slot
+constexpr uint8_t kMaxInflight = 2;
+constexpr uint8_t kMaxInflightPayload = 8;  // Payload is copied for retransmission
+constexpr uint16_t kPubackTimeoutMs = 3000;  // Resend with DUP after this
+
+// Outbound queue - 14 bytes per entry
+constexpr uint8_t kOutboundQueueSize = 4;
+constexpr uint8_t kMaxQueuedPayload = 8;
+
+// Outbound priority classes, flushed in this order
+enum class Priority : uint8_t { kRing = 0, kState = 1, kTelemetry = 2 };
+constexpr uint8_t kPriorityCount = 3;
+
+/**
+ * @brief Token bucket size per priority class (messages sent back to back).
+ */
+constexpr uint8_t token_burst(Priority priority) {
+  return (priority == Priority::kRing) ? 4 : ((priority == Priority::kState) ? 2 : 1);
+}
+
+/**
+ * @brief Time to regain one token per priority class in ms.
+ */
+constexpr uint16_t token_refill_ms(Priority priority) {
+  return (priority == Priority::kRing) ? 500 : ((priority == Priority::kState) ? 1000 : 5000);
+}
 
 // Connection states
 enum class State : uint8_t { DISCONNECTED, CONNECTING, CONNECTED, ERROR };
@@ -46,13 +88,55 @@ struct Config {
   char password[kMaxPasswordLength];
   uint16_t keepalive;
   bool use_auth;
+  bool clean_session;  // false = persistent session, broker keeps subscriptions
+
+  // W5500 retransmission timers, chip wide (also for the other TCP sockets).
+  // A dead broker surfaces after RTR + 2 RTR + ... (retry_count + 1 tries)
+  uint16_t retry_time_ms;  // RTR, 0 = adaptive: RTO from the measured RTT
+  uint8_t retry_count;     // RCR, 0 = kDefaultRetryCount
+
+  // Last Will and birth message on will_topic (nullptr = none). The strings are
+  // referenced, not copied; change them only together with another Config field
+  // (e.g. client_id) so connect() picks up the new lengths.
+  const char* will_topic;
+  const char* will_payload;   // Published by the broker when the connection dies
+  const char* birth_payload;  // Published by us after CONNACK, e.g. "online"
+  bool presence_in_flash;     // will_payload and birth_payload point to PROGMEM
+  QoS will_qos;
+  bool will_retain;  // Also applies to the birth message
 };
 
 // Subscription entry
 struct Subscription {
-  char topic[kMaxTopicLength];
+  const char* topic;    // Filter string, caller-owned (re-sent on reconnect)
+  bool topic_in_flash;  // topic points to PROGMEM
+  TopicFilter filter;   // Pre-hashed levels for dispatch
   MessageCallback callback;
+  uint16_t packet_id;  // SUBSCRIBE awaiting SUBACK (0 = acknowledged / not sent)
   bool active;
+  bool granted;  // SUBACK (or session present) confirmed this filter
+};
+
+// QoS 1 PUBLISH awaiting PUBACK
+struct InflightMessage {
+  const char* topic;  // Referenced like PreparedPublish::topic
+  uint8_t topic_length;
+  bool topic_in_flash;
+  uint8_t payload_length;
+  uint8_t payload[kMaxInflightPayload];
+  uint16_t packet_id;  // 0 = slot free
+  uint32_t sent_at;    // millis() of the last (re)transmission
+};
+
+// PUBLISH waiting in the outbound queue
+struct QueuedMessage {
+  const char* topic;  // Referenced like PreparedPublish::topic
+  uint8_t topic_length;
+  bool topic_in_flash;
+  uint8_t payload_length;
+  uint8_t payload[kMaxQueuedPayload];
+  Priority priority;
+  QoS qos;
 };
 
 /**
@@ -61,9 +145,14 @@ struct Subscription {
  * Design constraints:
  * - No dynamic allocation (no new/delete/malloc)
  * - Fixed-size static buffers
- * - QoS 0 only (fire-and-forget)
+ * - QoS 0, QoS 1 for selected publishes (window of kMaxInflight)
  * - Uses W5500 socket 2 for MQTT
  * - Minimal feature set for SmartBell use case
+ *
+ * Subscriptions are registered once and survive reconnects. On connect() with
+ * clean_session the client sends one SUBSCRIBE for all registered topics right
+ * behind CONNECT (no CONNACK round trip in between). With a persistent session
+ * the SUBSCRIBE is only sent if the broker reports no stored session.
  */
 class MinimalMQTT {
  public:
@@ -92,6 +181,13 @@ class MinimalMQTT {
    */
   void disconnect();
 
+  /**
+   * @brief Drop the connection at once, without DISCONNECT (e.g. link lost).
+   * The broker publishes the Last Will; QoS 1 messages stay in the window
+   * and are resent after the next connect().
+   */
+  void abort();
+
   /**
    * @brief Check if connected.
    */
@@ -111,22 +207,150 @@ class MinimalMQTT {
    */
   bool publish(const char* topic, const uint8_t* payload, uint16_t length);
 
+  /**
+   * @brief Publish message (QoS 0) on a topic in flash, e.g. FSTR("a/b").
+   * The topic is copied from flash into the send buffer, it never takes SRAM.
+   */
+  bool publish(const Utils::FlashString* topic, const uint8_t* payload, uint16_t length);
+
   /**
    * @brief Publish string message (QoS 0).
    */
   bool publish_string(const char* topic, const char* message);
 
   /**
-   * @brief Subscribe to topic.
-   * @param topic Topic string (max 47 chars).
+   * @brief Build the PUBLISH header for a runtime topic once.
+   * The topic is referenced, not copied, and must outlive the result.
+   * Literal topics should use MQTT::make_prepared_publish() instead.
+   */
+  static PreparedPublish prepare_publish(const char* topic, uint16_t payload_length);
+
+  /**
+   * @brief Publish with a pre-serialized header.
+   * Skips strlen and header encoding on the hot path.
+   *
+   * With QoS::kAtLeastOnce the message takes a slot of the in-flight window
+   * (payload copied, topic referenced) until the PUBACK arrives. It is resent
+   * with DUP after kPubackTimeoutMs and after a reconnect, so a TCP reset right
+   * after send() no longer loses it.
+   *
+   * @param packet Header from prepare_publish() / make_prepared_publish().
+   * @param payload packet.payload_length bytes of payload.
+   * @param qos Delivery guarantee.
+   * @return true if sent (QoS 0) or accepted into the window (QoS 1).
+   */
+  bool publish_prepared(const PreparedPublish& packet, const uint8_t* payload,
+                        QoS qos = QoS::kAtMostOnce);
+
+  /**
+   * @brief Queue a PUBLISH for the next loop().
+   *
+   * loop() flushes the queue by priority (ring > state > telemetry), each
+   * class limited by a token bucket (token_burst / token_refill_ms), and
+   * gathers consecutive QoS 0 messages into as few TCP sends as possible.
+   * A kState message replaces a still queued one for the same topic. When the
+   * queue is full, a lower priority message is dropped to make room.
+   * Queued messages survive a reconnect.
+   *
+   * @param packet Header from prepare_publish() / make_prepared_publish().
+   * @param payload Up to kMaxQueuedPayload bytes, copied.
+   * @param priority Priority class.
+   * @param qos Delivery guarantee.
+   * @return true if queued.
+   */
+  bool queue_publish(const PreparedPublish& packet, const uint8_t* payload, Priority priority,
+                     QoS qos = QoS::kAtMostOnce);
+
+  /**
+   * @brief Number of messages in the outbound queue.
+   */
+  uint8_t queued_count() const { return queue_count_; }
+
+  /**
+   * @brief Number of QoS 1 messages still waiting for PUBACK.
+   */
+  uint8_t inflight_count() const;
+
+  /**
+   * @brief Time from the last (re)transmission to its PUBACK in ms.
+   * This is the latency QoS 1 adds over QoS 0.
+   */
+  uint16_t last_puback_latency_ms() const { return last_puback_latency_ms_; }
+
+  /**
+   * @brief Smoothed round trip to the broker (TCP handshake, PINGREQ) in ms.
+   */
+  uint16_t rtt_ms() const { return rtt_.srtt_ms(); }
+
+  /**
+   * @brief W5500 retry time (RTR) currently in use in ms.
+   */
+  uint16_t retry_time_ms() const;
+
+  /**
+   * @brief Time until loop() sends the next PINGREQ in ms, 0 if due.
+   */
+  uint32_t next_ping_in_ms() const;
+
+  /**
+   * @brief Connected and nothing queued, in flight, unacknowledged by TCP or
+   * waiting for PINGRESP: the link may go away until next_ping_in_ms().
+   */
+  bool is_idle() const;
+
+  /**
+   * @brief Packets handed to the W5500 that it has not sent yet.
+   * Goes false once Sn_IR_SENDOK reported the last SEND and nothing new was
+   * written since. Polled by loop(), no TCP ACK implied.
+   */
+  bool send_pending() const { return send_in_flight_ || tx_unsent_ != 0; }
+
+  /**
+   * @brief Subscribe to topic filter.
+   *
+   * Registers the filter in the subscription table. When connected, a SUBSCRIBE
+   * is sent immediately; otherwise it is sent on the next connect().
+   * Registering an already known filter only updates its callback.
+   *
+   * Wildcards '+' (one level) and '#' (remaining levels) are supported, so a
+   * single "smartbell/gong/#" slot covers every gong control topic. The string
+   * is referenced, not copied, and must stay valid while registered.
+   * Incoming PUBLISHes go to the first registered filter that matches.
+   *
+   * @param topic Topic filter (max kMaxTopicLevels levels).
    * @param callback Message callback.
-   * @return true if subscription sent.
+   * @return true if registered (and sent, when connected).
    */
   bool subscribe(const char* topic, MessageCallback callback);
 
+  /**
+   * @brief Subscribe to a topic filter in flash, e.g. FSTR("smartbell/gong/#").
+   * Same as above; the filter is read from flash for every SUBSCRIBE.
+   */
+  bool subscribe(const Utils::FlashString* topic, MessageCallback callback);
+
+  /**
+   * @brief Remove all registered subscriptions (no UNSUBSCRIBE is sent).
+   * Use before registering a changed topic set; reconnect with clean_session
+   * so the broker drops the old filters as well.
+   */
+  void clear_subscriptions();
+
+  /**
+   * @brief Check whether the broker acknowledged all registered subscriptions.
+   */
+  bool subscriptions_granted() const;
+
+  /**
+   * @brief Session present flag from the last CONNACK.
+   */
+  bool session_present() const { return session_present_; }
+
   /**
    * @brief Process incoming messages and handle keepalive.
    * Must be called regularly (at least every second).
+   * Handles all buffered packets, bounded by kRecvBudgetMs; the rest stays in
+   * the W5500 RX buffer for the next call.
    */
   void loop();
 
@@ -135,21 +359,43 @@ class MinimalMQTT {
   bool socket_connect();
   void socket_disconnect();
   bool socket_send(const uint8_t* data, uint16_t length);
+  uint16_t socket_tx_space() const;
+  void service_send();
+  void drain_send();
   int16_t socket_recv(uint8_t* buffer, uint16_t max_length);
   bool socket_is_connected();
 
   // MQTT protocol
   bool send_connect_packet();
+  bool send_subscribe_packet(uint8_t slot_mask);
+  bool add_subscription(const char* topic, bool in_flash, MessageCallback callback);
   bool wait_for_connack();
+  void apply_retry_timers();
+  uint32_t segment_timeout_ms() const;
   void send_pingreq();
-  void process_incoming_packet();
+  void process_incoming_packets();
+  void handle_packet(const Packet& packet);
+  void handle_publish(const Packet& packet);
+  void handle_suback(const Packet& packet);
+  void handle_puback(const Packet& packet);
+  bool publish_qos1(const PreparedPublish& packet, const uint8_t* payload);
+  bool send_inflight(InflightMessage& message, bool dup);
+  void retransmit_inflight(bool all);
+  uint16_t next_packet_id();
+  void flush_outbound();
+  bool send_batch(uint16_t length);
+  void refill_tokens();
+  void remove_queued(uint8_t index);
+  uint8_t active_subscription_mask() const;
 
   // Packet building helpers
-  uint16_t encode_string(uint8_t* buffer, const char* str);
+  uint16_t encode_string(uint8_t* buffer, const char* str, uint8_t length, bool in_flash = false);
+  bool append_string(uint16_t& pos, const char* str, uint8_t length, bool in_flash = false);
+  static uint16_t string_length(const char* str, bool in_flash);
+  static void copy_topic(uint8_t* dest, const char* topic, uint8_t length, bool in_flash);
   uint16_t encode_remaining_length(uint8_t* buffer, uint16_t length);
-
-  // Logging helper
-  void log(const char* message);
+  void update_connect_cache();
+  void publish_birth();
 
   // State
   serial::UART* uart_;
@@ -159,16 +405,52 @@ class MinimalMQTT {
   // Buffers (statically allocated)
   uint8_t send_buffer_[kSendBufferSize];
   uint8_t recv_buffer_[kRecvBufferSize];
+  PacketFramer framer_;  // Cuts the TCP stream in recv_buffer_ into packets
 
   // Subscriptions
   Subscription subscriptions_[kMaxSubscriptions];
 
+  // QoS 1 messages awaiting PUBACK
+  InflightMessage inflight_[kMaxInflight];
+  uint16_t last_puback_latency_ms_;
+
+  // Outbound queue (FIFO per priority class) and token buckets
+  QueuedMessage queue_[kOutboundQueueSize];
+  uint8_t queue_count_;
+  uint8_t tokens_[kPriorityCount];
+  uint32_t last_refill_[kPriorityCount];
+
   // Timing
   uint32_t last_activity_;  // millis() of last send/recv
   uint32_t last_ping_;      // millis() of last PINGREQ
+  bool ping_pending_;       // PINGREQ sent, PINGRESP is an RTT sample
+
+  // Asynchronous send: packets are written to the W5500 TX buffer right away,
+  // one SEND command covers all bytes written since the previous SEND
+  uint16_t tx_unsent_;   // Written to the TX buffer, no SEND issued yet
+  bool send_in_flight_;  // SEND issued, Sn_IR_SENDOK not seen yet
+
+  // Broker RTT and the retransmission timers derived from it
+  RttEstimator rtt_;
+  uint16_t applied_rtr_ms_;  // Last values written to the W5500 (0 = none)
+  uint8_t applied_rcr_;
 
   // Packet ID counter
   uint16_t packet_id_;
+
+  // Session present flag of the last CONNACK
+  bool session_present_;
+
+  // CONNECT string lengths, recomputed only when the config changes
+  struct ConnectCache {
+    uint8_t client_id_length;
+    uint8_t username_length;
+    uint8_t password_length;
+    uint8_t will_topic_length;
+    uint8_t will_payload_length;
+    uint16_t remaining_length;
+  };
+  ConnectCache connect_cache_;
 };
 
 }  // namespace MQTT
@@ -0,0 +1,112 @@
+#ifndef PUBLIC_MQTT_MINIMALMQTTSN_H_
+#define PUBLIC_MQTT_MINIMALMQTTSN_H_
+
+#include <stdint.h>
+#include "MQTT/MQTTSNPackets.h"
+#include "Serial/UART.h"
+
+namespace MQTT {
+namespace SN {
+
+// Buffer for one datagram - PUBLISH with a short payload or CONNECT
+constexpr uint8_t kBufferSize = 24;
+
+// Connection states
+enum class State : uint8_t {
+  CLOSED,      // UDP socket not open
+  READY,       // Socket open, QoS -1 publishes possible
+  CONNECTING,  // CONNECT sent, waiting for CONNACK
+  CONNECTED    // Gateway accepted CONNECT, QoS 0 publishes possible
+};
+
+}  // namespace SN
+
+/**
+ * @brief Minimal MQTT-SN 1.2 client over UDP for W5500 on ATmega328P.
+ *
+ * Fast path for button events: with topic ids pre-registered at the gateway
+ * (predefined topic ids), a press is a single ~8 byte datagram. QoS -1 needs
+ * neither a connection to the gateway nor any round trip, so it works right
+ * after boot and while the TCP session on socket 2 is still recovering.
+ *
+ * Uses W5500 socket 3, no dynamic allocation, 24 byte buffer.
+ */
+class MinimalMQTTSN {
+ public:
+  static constexpr uint8_t kSocketNumber = 3;
+  static constexpr uint16_t kLocalPort = 10001;
+
+  /**
+   * @brief Construct MQTT-SN client.
+   * @param uart Optional UART for debug logging (nullptr to disable).
+   */
+  explicit MinimalMQTTSN(serial::UART* uart = nullptr);
+  ~MinimalMQTTSN() = default;
+
+  // Prevent copying
+  MinimalMQTTSN(const MinimalMQTTSN&) = delete;
+  MinimalMQTTSN& operator=(const MinimalMQTTSN&) = delete;
+
+  /**
+   * @brief Open the UDP socket towards the gateway.
+   * @param gateway_ip Gateway IPv4 address.
+   * @param gateway_port Gateway UDP port.
+   * @return true if the socket is open (QoS -1 publishes possible).
+   */
+  bool begin(const uint8_t* gateway_ip, uint16_t gateway_port = SN::kDefaultGatewayPort);
+
+  /**
+   * @brief Close the UDP socket.
+   */
+  void end();
+
+  /**
+   * @brief Send CONNECT, CONNACK is handled by loop().
+   * Only needed for QoS 0 publishes.
+   * @param client_id Client identifier.
+   * @param keepalive Keepalive duration in seconds.
+   */
+  bool connect(const char* client_id, uint16_t keepalive);
+
+  /**
+   * @brief Publish to a pre-registered topic id.
+   * @param topic_id Predefined topic id configured at the gateway.
+   * @param payload Payload data.
+   * @param length Payload length (max kBufferSize - 7).
+   * @param qos kMinusOne (connectionless) or kAtMostOnce (requires connect()).
+   * @return true if the datagram was sent.
+   */
+  bool publish(uint16_t topic_id, const uint8_t* payload, uint8_t length,
+               SN::QoS qos = SN::QoS::kMinusOne);
+
+  /**
+   * @brief Process gateway replies and keepalive.
+   */
+  void loop();
+
+  /**
+   * @brief Get current state.
+   */
+  SN::State get_state() const { return state_; }
+
+  /**
+   * @brief Check if connected to the gateway (QoS 0 possible).
+   */
+  bool is_connected() const { return state_ == SN::State::CONNECTED; }
+
+ private:
+  bool send_datagram(uint8_t length);
+
+  serial::UART* uart_;
+  SN::State state_;
+  uint8_t gateway_ip_[4];
+  uint16_t gateway_port_;
+  uint16_t keepalive_;
+  uint32_t last_activity_;  // millis() of last datagram from the gateway
+  uint32_t last_ping_;      // millis() of last PINGREQ
+  uint8_t buffer_[SN::kBufferSize];
+};
+
+}  // namespace MQTT
+
+#endif  // PUBLIC_MQTT_MINIMALMQTTSN_H_
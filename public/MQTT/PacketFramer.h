@@ -0,0 +1,89 @@
+#ifndef PUBLIC_MQTT_PACKETFRAMER_H_
+#define PUBLIC_MQTT_PACKETFRAMER_H_
+
+#include <stdint.h>
+
+namespace MQTT {
+
+/**
+ * @brief One complete MQTT control packet inside the framer buffer.
+ * Only valid until the next call on the framer.
+ */
+struct Packet {
+  uint8_t header;       // Fixed header byte (type + flags)
+  const uint8_t* body;  // Variable header + payload
+  uint16_t length;      // Remaining length
+};
+
+/**
+ * @brief Incremental framer for the MQTT byte stream.
+ *
+ * TCP delivers a byte stream, not packets: one recv() may contain several
+ * packets (PINGRESP + PUBLISH, a burst of retained messages) or only part of
+ * one. Received bytes are appended to the caller's buffer and cut into packets
+ * by a small state machine (header -> remaining length -> body). Partial
+ * packets stay buffered across calls, packets larger than the buffer are
+ * skipped without buffering them.
+ *
+ * Usage:
+ *   recv(framer.free_space(), framer.free_length()) -> framer.commit(n)
+ *   while (framer.next(packet)) { ... }
+ */
+class PacketFramer {
+ public:
+  /**
+   * @param buffer Storage for partial packets (e.g. the client's recv buffer).
+   * @param capacity Buffer size, also the largest packet that is delivered.
+   */
+  PacketFramer(uint8_t* buffer, uint16_t capacity);
+
+  /**
+   * @brief Drop all buffered bytes (new TCP connection).
+   */
+  void reset();
+
+  /**
+   * @brief Free space behind the buffered bytes for the next recv().
+   */
+  uint8_t* free_space();
+  uint16_t free_length();
+
+  /**
+   * @brief Account for @p length bytes written to free_space().
+   */
+  void commit(uint16_t length);
+
+  /**
+   * @brief Extract the next complete packet.
+   * @return false if more bytes are needed (or the stream is malformed).
+   */
+  bool next(Packet& packet);
+
+  /**
+   * @brief Stream is malformed (invalid remaining length), reconnect required.
+   */
+  bool error() const { return state_ == State::kError; }
+
+  /**
+   * @brief Number of packets skipped because they exceeded the buffer.
+   */
+  uint8_t dropped() const { return dropped_; }
+
+ private:
+  enum class State : uint8_t { kHeader, kLength, kBody, kDiscard, kError };
+
+  void drop(uint16_t length);
+
+  uint8_t* buffer_;
+  uint16_t capacity_;
+  uint16_t fill_;       // Buffered bytes
+  uint16_t consumed_;   // Bytes of the last delivered packet, dropped lazily
+  uint32_t remaining_;  // Decoded remaining length / bytes left to discard
+  State state_;
+  uint8_t length_bytes_;  // Remaining length bytes decoded so far
+  uint8_t dropped_;
+};
+
+}  // namespace MQTT
+
+#endif  // PUBLIC_MQTT_PACKETFRAMER_H_
@@ -0,0 +1,158 @@
+#ifndef PUBLIC_MQTT_PACKETTEMPLATES_H_
+#define PUBLIC_MQTT_PACKETTEMPLATES_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace MQTT {
+
+// MQTT Protocol Constants
+constexpr uint8_t kMQTTProtocolLevel = 4;  // MQTT 3.1.1
+
+// MQTT Message Types
+enum class MessageType : uint8_t {
+  CONNECT = 0x10,
+  CONNACK = 0x20,
+  PUBLISH = 0x30,
+  PUBACK = 0x40,
+  SUBSCRIBE = 0x82,
+  SUBACK = 0x90,
+  PINGREQ = 0xC0,
+  PINGRESP = 0xD0,
+  DISCONNECT = 0xE0
+};
+
+// CONNECT flag bits
+constexpr uint8_t kConnectFlagCleanSession = 0x02;
+constexpr uint8_t kConnectFlagWill = 0x04;
+constexpr uint8_t kConnectWillQosShift = 3;
+constexpr uint8_t kConnectFlagWillRetain = 0x20;
+constexpr uint8_t kConnectFlagPassword = 0x40;
+constexpr uint8_t kConnectFlagUsername = 0x80;
+
+// PUBLISH fixed header flags
+constexpr uint8_t kPublishFlagDup = 0x08;
+constexpr uint8_t kPublishFlagQos1 = 0x02;
+constexpr uint8_t kPublishFlagRetain = 0x01;
+
+// Delivery guarantee of a PUBLISH
+enum class QoS : uint8_t { kAtMostOnce = 0, kAtLeastOnce = 1 };
+
+// Fixed header (1) + remaining length (max 2 for our buffers) + topic length (2)
+constexpr uint8_t kMaxPublishHeaderLength = 5;
+
+/**
+ * @brief Fixed-size byte sequence produced at compile time.
+ */
+template <uint8_t N>
+struct PacketTemplate {
+  uint8_t bytes[N];
+
+  static constexpr uint8_t size() { return N; }
+};
+
+/**
+ * @brief Pre-serialized PUBLISH header for one topic and payload length.
+ *
+ * Holds everything in front of the payload except the topic bytes themselves,
+ * which are referenced instead of copied. Built at compile time for literal
+ * topics (make_prepared_publish) or once at runtime for config topics.
+ */
+struct PreparedPublish {
+  const char* topic;
+  uint8_t topic_length;
+  bool topic_in_flash;  // topic points to PROGMEM (make_prepared_publish_P)
+  uint8_t header[kMaxPublishHeaderLength];  // fixed header + remaining length + topic length
+  uint8_t header_length;
+  uint16_t payload_length;
+};
+
+/**
+ * @brief Packet without variable header (PINGREQ, DISCONNECT).
+ */
+constexpr PacketTemplate<2> make_empty_packet(MessageType type) {
+  return {{static_cast<uint8_t>(type), 0}};
+}
+
+/**
+ * @brief Number of bytes the variable length encoding of @p length takes.
+ */
+constexpr uint8_t remaining_length_size(uint16_t length) {
+  return (length < 128) ? 1 : ((length < 16384) ? 2 : 3);
+}
+
+/**
+ * @brief CONNECT flags byte.
+ */
+constexpr uint8_t connect_flags(bool clean_session, bool use_auth, bool will = false,
+                                QoS will_qos = QoS::kAtMostOnce, bool will_retain = false) {
+  return (clean_session ? kConnectFlagCleanSession : 0) |
+         (use_auth ? (kConnectFlagUsername | kConnectFlagPassword) : 0) |
+         (will ? (kConnectFlagWill | (static_cast<uint8_t>(will_qos) << kConnectWillQosShift) |
+                  (will_retain ? kConnectFlagWillRetain : 0))
+               : 0);
+}
+
+/**
+ * @brief Build the PUBLISH (QoS 0) header for a topic of known length.
+ * Usable at compile time and at runtime.
+ */
+constexpr PreparedPublish prepare_publish_header(const char* topic, uint8_t topic_length,
+                                                 uint16_t payload_length,
+                                                 bool topic_in_flash = false) {
+  PreparedPublish packet{};
+  uint16_t remaining = 2 + topic_length + payload_length;
+  uint8_t pos = 0;
+
+  packet.header[pos++] = static_cast<uint8_t>(MessageType::PUBLISH);
+  if (remaining < 128) {
+    packet.header[pos++] = remaining & 0x7F;
+  } else {
+    packet.header[pos++] = (remaining & 0x7F) | 0x80;
+    packet.header[pos++] = (remaining >> 7) & 0x7F;
+  }
+  packet.header[pos++] = 0;
+  packet.header[pos++] = topic_length;
+
+  packet.topic = topic;
+  packet.topic_length = topic_length;
+  packet.topic_in_flash = topic_in_flash;
+  packet.header_length = pos;
+  packet.payload_length = payload_length;
+  return packet;
+}
+
+/**
+ * @brief Compile-time PUBLISH header for a literal topic.
+ */
+template <size_t N>
+constexpr PreparedPublish make_prepared_publish(const char (&topic)[N], uint16_t payload_length) {
+  static_assert(N - 1 < 256, "Topic too long for a prepared PUBLISH");
+  return prepare_publish_header(topic, static_cast<uint8_t>(N - 1), payload_length);
+}
+
+/**
+ * @brief Same for a topic array declared PROGMEM; the topic stays in flash and
+ * is copied straight into the send buffer.
+ */
+template <size_t N>
+constexpr PreparedPublish make_prepared_publish_P(const char (&progmem_topic)[N],
+                                                  uint16_t payload_length) {
+  static_assert(N - 1 < 256, "Topic too long for a prepared PUBLISH");
+  return prepare_publish_header(progmem_topic, static_cast<uint8_t>(N - 1), payload_length, true);
+}
+
+// Constant packets
+constexpr PacketTemplate<2> kPingreqPacket = make_empty_packet(MessageType::PINGREQ);
+constexpr PacketTemplate<2> kDisconnectPacket = make_empty_packet(MessageType::DISCONNECT);
+
+// CONNECT variable header up to (excluding) the flags: protocol name "MQTT" + level
+constexpr PacketTemplate<7> kConnectProtocolHeader = {
+    {0, 4, 'M', 'Q', 'T', 'T', kMQTTProtocolLevel}};
+
+// Protocol header(7) + flags(1) + keepalive(2)
+constexpr uint8_t kConnectVariableHeaderLength = kConnectProtocolHeader.size() + 3;
+
+}  // namespace MQTT
+
+#endif  // PUBLIC_MQTT_PACKETTEMPLATES_H_
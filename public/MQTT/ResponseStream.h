@@ -0,0 +1,58 @@
+#ifndef PUBLIC_MQTT_RESPONSESTREAM_H_
+#define PUBLIC_MQTT_RESPONSESTREAM_H_
+
+#include <stdint.h>
+#include "Serial/Interface.h"
+
+namespace MQTT {
+
+class MinimalMQTT;
+
+/**
+ * @brief Console output sink that streams into small PUBLISH packets.
+ *
+ * Lets the existing UART command processor answer remote commands: every
+ * kChunkLength bytes of output go out as one QoS 0 PUBLISH
+ * "<correlation id>:<text>" on the response topic, finish() sends the rest
+ * and an empty "<correlation id>." end marker. Only one chunk is buffered,
+ * the object lives on the stack for the duration of one command.
+ */
+class ResponseStream : public serial::Interface {
+ public:
+  static constexpr uint8_t kChunkLength = 24;
+  static constexpr uint8_t kMaxCorrelationLength = 8;
+
+  /**
+   * @param client Connected MQTT client.
+   * @param topic Response topic, referenced.
+   * @param correlation_id Id from the request, truncated to kMaxCorrelationLength.
+   * @param correlation_length Length of @p correlation_id.
+   */
+  ResponseStream(MinimalMQTT& client, const char* topic, const char* correlation_id,
+                 uint8_t correlation_length);
+
+  void send(const uint8_t byte) override;
+  void send_bytes(const uint8_t* const bytes, const uint16_t length) override;
+  void send_string(const char* string) override;
+  using Interface::send_string;
+
+  /**
+   * @brief Publish the remaining output and the end marker.
+   * @return false if any chunk could not be sent.
+   */
+  bool finish();
+
+ private:
+  bool flush(char separator);
+
+  MinimalMQTT* client_;
+  const char* topic_;
+  uint8_t chunk_[kMaxCorrelationLength + 1 + kChunkLength];
+  uint8_t prefix_length_;  // Correlation id, the separator follows
+  uint8_t length_;         // Output bytes behind the separator
+  bool ok_;
+};
+
+}  // namespace MQTT
+
+#endif  // PUBLIC_MQTT_RESPONSESTREAM_H_
@@ -0,0 +1,74 @@
+#ifndef PUBLIC_MQTT_RTTESTIMATOR_H_
+#define PUBLIC_MQTT_RTTESTIMATOR_H_
+
+#include <stdint.h>
+
+namespace MQTT {
+
+/**
+ * @brief Round trip time estimate (RFC 6298) for the W5500 retransmission timer.
+ *
+ * Smoothed RTT and its variance are kept in fixed point (SRTT x8, RTTVAR x4),
+ * so an update is a few shifts and adds. rto_ms() is the retry time (RTR) for
+ * the W5500; timeout_ms() is how long the W5500 needs with that retry time to
+ * give up on a segment, which is what connect and CONNACK waits are based on.
+ */
+class RttEstimator {
+ public:
+  /// W5500 reset value of RTR, used until the first sample
+  static constexpr uint16_t kInitialRtoMs = 200;
+
+  /// RTO clamp. On the LAN RTTs are ~1 ms, the floor covers broker hiccups
+  static constexpr uint16_t kMinRtoMs = 50;
+  static constexpr uint16_t kMaxRtoMs = 2000;
+
+  /// Largest RTR the W5500 can hold (16 bit in 100 us units)
+  static constexpr uint16_t kMaxRtrMs = 6553;
+
+  RttEstimator() : srtt_x8_(0), rttvar_x4_(0), backoff_rto_ms_(0), has_sample_(false) {}
+
+  /**
+   * @brief Add a measured round trip (never one of a retransmitted segment).
+   * Ends a backoff, the RTO is SRTT + 4 RTTVAR again.
+   */
+  void add_sample(uint16_t rtt_ms);
+
+  /**
+   * @brief Karn's backoff: double the RTO (capped at kMaxRtoMs) after a round
+   * trip that took longer than it. Such a round trip gives no sample, without
+   * the backoff the RTO could never grow past the real RTT.
+   */
+  void backoff();
+
+  bool has_sample() const { return has_sample_; }
+
+  /**
+   * @brief Smoothed round trip time.
+   */
+  uint16_t srtt_ms() const { return static_cast<uint16_t>(srtt_x8_ >> 3); }
+
+  /**
+   * @brief Retransmission timeout SRTT + 4 RTTVAR, clamped, or the backed off
+   * value until the next sample.
+   */
+  uint16_t rto_ms() const;
+
+  /**
+   * @brief Time until the W5500 reports TIMEOUT for an unanswered segment.
+   * The W5500 doubles RTR per retransmission (capped at kMaxRtrMs):
+   * RTR + 2 RTR + 4 RTR + ... for 1 + @p retry_count transmissions.
+   * @param retry_time_ms RTR in ms.
+   * @param retry_count RCR.
+   */
+  static uint32_t timeout_ms(uint16_t retry_time_ms, uint8_t retry_count);
+
+ private:
+  uint32_t srtt_x8_;
+  uint32_t rttvar_x4_;
+  uint16_t backoff_rto_ms_;  // 0 = no backoff
+  bool has_sample_;
+};
+
+}  // namespace MQTT
+
+#endif  // PUBLIC_MQTT_RTTESTIMATOR_H_
@@ -0,0 +1,73 @@
+#ifndef PUBLIC_MQTT_TOPICFILTER_H_
+#define PUBLIC_MQTT_TOPICFILTER_H_
+
+#include <stdint.h>
+
+namespace MQTT {
+
+// Deepest topic level a filter may address (SmartBell topics use 4)
+constexpr uint8_t kMaxTopicLevels = 6;
+
+/**
+ * @brief Per-level hashes of a received topic, computed once per PUBLISH.
+ *
+ * Levels beyond kMaxTopicLevels are counted but not hashed - only a filter
+ * ending in '#' at a shallower level can match such a topic.
+ */
+struct TopicHashes {
+  uint16_t level_hash[kMaxTopicLevels];
+  uint8_t levels;  // Total number of levels in the topic
+  bool system;     // Topic starts with '$' (never matched by a leading wildcard)
+
+  /**
+   * @brief Hash all levels of a topic in a single pass.
+   * @param topic Topic bytes (need not be null-terminated).
+   * @param length Topic length.
+   */
+  void compute(const char* topic, uint16_t length);
+};
+
+/**
+ * @brief Subscription filter with '+' / '#' wildcards, pre-hashed per level.
+ *
+ * Compiled once at subscribe time (15 bytes). Matching a topic is then a
+ * handful of 16-bit compares instead of a string walk per filter. A 16-bit hash
+ * can collide, so a hit is confirmed against the filter string before use.
+ */
+struct TopicFilter {
+  uint16_t level_hash[kMaxTopicLevels];  // Hash of each literal level
+  uint8_t levels;                        // Levels in front of a trailing '#'
+  uint8_t single_level_mask;             // Bit n set: level n is '+'
+  bool multi_level;                      // Filter ends with '#'
+
+  /**
+   * @brief Parse and pre-hash a filter string.
+   * @param filter Null-terminated filter, e.g. "smartbell/gong/#".
+   * @return false if the filter is malformed or deeper than kMaxTopicLevels.
+   */
+  bool compile(const char* filter);
+
+  /**
+   * @brief Check whether a received topic matches this filter (fast reject).
+   */
+  bool matches(const TopicHashes& topic) const;
+
+  /**
+   * @brief Confirm a hit of matches() by comparing the literal levels of the
+   * filter string with the topic.
+   * @param filter The string this filter was compiled from.
+   * @param filter_in_flash @p filter points to PROGMEM.
+   * @param topic Topic bytes (need not be null-terminated).
+   * @param length Topic length.
+   */
+  bool confirm(const char* filter, bool filter_in_flash, const char* topic, uint16_t length) const;
+};
+
+/**
+ * @brief Hash of one topic level (FNV-1a folded to 16 bit).
+ */
+uint16_t topic_level_hash(const char* level, uint16_t length);
+
+}  // namespace MQTT
+
+#endif  // PUBLIC_MQTT_TOPICFILTER_H_
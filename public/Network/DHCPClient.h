@@ -2,7 +2,6 @@
 #define PUBLIC_NETWORK_DHCPCLIENT_H_
 
 #include <stdint.h>
-#include "Ethernet/EmbeddedSocketInterface.h"
 #include "Ethernet/W5500/W5500Interface.h"
 #include "Serial/Interface.h"
 
@@ -12,7 +11,7 @@ namespace SmartBell {
  * @brief DHCP client status codes.
  */
 enum class DHCPStatus : uint8_t {
-  kFailed = 0,     ///< DHCP process failed
+  kFailed = 0,     ///< Lease lost, back to DISCOVER
   kRunning = 1,    ///< DHCP is in progress
   kIPAssign = 2,   ///< First IP assignment
   kIPChanged = 3,  ///< IP address changed
@@ -28,22 +27,36 @@ struct NetworkConfig {
   uint8_t subnet[4];
   uint8_t gateway[4];
   uint8_t dns[4];
-  uint32_t lease_time;
+  uint32_t lease_time;  // Seconds
 };
 
 /**
- * @brief C++ wrapper for WIZnet ioLibrary DHCP client.
+ * @brief Non-blocking DHCP client (RFC 2131) for the W5500.
  *
- * Provides automatic IP configuration via DHCP protocol.
- * Uses UDP socket 0 for DHCP communication.
+ * Uses UDP socket 0. Packets are never held in SRAM: requests are written
+ * into the W5500 TX buffer piece by piece and replies are parsed straight
+ * out of the RX buffer through a DatagramReader chunk on the stack, so the socket
+ * buffers are the only DHCP buffer (instead of a 548 byte dhcp_buffer_).
+ *
+ * The last lease is cached in EEPROM. After a reboot the client first sends
+ * a DHCPREQUEST for the cached address (INIT-REBOOT) and is bound after one
+ * round trip; only a NAK or no answer falls back to DISCOVER/OFFER/REQUEST.
+ * Renewal (T1 = lease/2, unicast) and rebinding (T2 = 7/8 lease, broadcast)
+ * run in the background from run().
  */
 class DHCPClient {
  public:
   /// Default socket number for DHCP (UDP socket)
   static constexpr uint8_t kDHCPSocket = 0;
 
-  /// Buffer size for DHCP messages
-  static constexpr uint16_t kDHCPBufferSize = 548;
+  /// Retransmission interval while acquiring
+  static constexpr uint16_t kRetryMs = 4000;
+
+  /// Retransmission interval while renewing / rebinding (still bound)
+  static constexpr uint16_t kRenewRetryMs = 60000;
+
+  /// INIT-REBOOT attempts before falling back to DISCOVER
+  static constexpr uint8_t kRebootAttempts = 2;
 
   /**
    * @brief Construct DHCP client.
@@ -51,23 +64,25 @@ class DHCPClient {
    * @param uart Optional UART for debug logging (can be nullptr).
    */
   DHCPClient(Ethernet::W5500Interface* w5500, serial::Interface* uart = nullptr);
-  ~DHCPClient();
 
   /**
-   * @brief Initialize DHCP client.
-   * Must be called before run().
+   * @brief Open the socket and send the first request.
+   * Starts with INIT-REBOOT if a lease for @p mac is cached.
+   * @param mac Own MAC address (chaddr), referenced.
    */
-  void init();
+  void init(const uint8_t* mac);
 
   /**
    * @brief Run DHCP state machine.
-   * Call this repeatedly in main loop until IP is leased.
+   * Call this repeatedly in main loop, also after the lease is bound.
+   * @param rx_ready false: skip the RX buffer (EmbeddedSocketW5500::poll()
+   *        reported no RECV on kDHCPSocket), only timers run.
    * @return Current DHCP status.
    */
-  DHCPStatus run();
+  DHCPStatus run(bool rx_ready = true);
 
   /**
-   * @brief Stop DHCP client.
+   * @brief Stop DHCP client and close the socket.
    */
   void stop();
 
@@ -75,13 +90,13 @@ class DHCPClient {
    * @brief Check if IP has been successfully obtained.
    * @return true if DHCP lease is active.
    */
-  bool has_ip() const;
+  bool has_ip() const { return has_ip_; }
 
   /**
    * @brief Get obtained network configuration.
    * @return Network configuration structure.
    */
-  const NetworkConfig& get_config() const;
+  const NetworkConfig& get_config() const { return config_; }
 
   /**
    * @brief Get assigned IP address.
@@ -113,38 +128,53 @@ class DHCPClient {
   void apply_config();
 
  private:
+  enum class State : uint8_t {
+    kStopped,
+    kInitReboot,  // REQUEST for the cached address sent
+    kSelecting,   // DISCOVER sent, waiting for OFFER
+    kRequesting,  // REQUEST for the offered address sent
+    kBound,
+    kRenewing,   // T1 passed, unicast REQUEST to the server
+    kRebinding,  // T2 passed, broadcast REQUEST
+  };
+
+  // Fields of a received reply that matter to us
+  struct Reply {
+    uint8_t type;
+    uint8_t ip[4];
+    uint8_t subnet[4];
+    uint8_t gateway[4];
+    uint8_t dns[4];
+    uint8_t server[4];
+    uint32_t lease_time;
+  };
+
   Ethernet::W5500Interface* w5500_;
   serial::Interface* uart_;
+  const uint8_t* mac_;
 
-  uint8_t dhcp_buffer_[kDHCPBufferSize];
   NetworkConfig config_;
-  bool initialized_;
+  uint8_t offered_ip_[4];
+  uint8_t server_[4];
+  uint32_t xid_;
+  uint32_t last_send_ms_;
+  uint32_t lease_start_ms_;
+  State state_;
+  uint8_t attempts_;
   bool has_ip_;
-  DHCPStatus last_status_;
-
-  /**
-   * @brief Log message to UART if available.
-   * @param message Message to log.
-   */
-  void log(const char* message);
-
-  /**
-   * @brief Log IP address to UART.
-   * @param label Label for the IP.
-   * @param ip IP address bytes.
-   */
-  void log_ip(const char* label, const uint8_t* ip);
-
-  /**
-   * @brief Update config from DHCP server response.
-   */
-  void update_config_from_dhcp();
-
-  // Static callbacks for ioLibrary
-  static DHCPClient* instance_;
-  static void on_ip_assign();
-  static void on_ip_update();
-  static void on_ip_conflict();
+  DHCPStatus pending_status_;  // Reported once by the next run()
+
+  void send_discover();
+  void send_request();
+  void send_message(uint8_t type);
+  bool receive_reply(Reply& reply);
+  void handle_reply(const Reply& reply);
+  void restart();
+  uint32_t lease_elapsed_s() const;
+
+  bool load_cache();
+  void save_cache();
+  void invalidate_cache();
 };
 
 }  // namespace SmartBell
@@ -10,88 +10,132 @@ namespace SmartBell {
  * @brief DNS resolution result.
  */
 enum class DNSResult : int8_t {
-  kDomainTooLong = -1,  ///< Domain name exceeds MAX_DOMAIN_NAME
-  kFailed = 0,          ///< Resolution failed (timeout or parse error)
-  kSuccess = 1          ///< Resolution successful
+  kDomainTooLong = -1,  ///< Hostname exceeds kMaxHostnameLength
+  kFailed = 0,          ///< Invalid hostname, or resolution failed
+  kSuccess = 1          ///< Hostname accepted / resolved
 };
 
 /**
- * @brief C++ wrapper for WIZnet ioLibrary DNS client.
+ * @brief Non-blocking DNS resolver for the broker hostname.
  *
- * Provides hostname resolution to IP address.
- * Uses UDP socket 1 for DNS queries.
- * DNS is blocking and can take up to MAX_DNS_RETRY * DNS_WAIT_TIME seconds (default 6s).
+ * Uses UDP socket 1. Queries are written into the W5500 TX buffer and A
+ * records are parsed out of the RX buffer (see DatagramReader), there is no
+ * DNS buffer in SRAM.
+ *
+ * One entry is cached in EEPROM: hostname, last address and its TTL. After
+ * a reboot the cached address is usable at once and a refresh runs in the
+ * background from run(); after that the entry is refreshed when its TTL
+ * expires. While a refresh is pending or failing the old address stays in
+ * use, so a reconnect never waits for DNS.
  */
 class DNSClient {
  public:
   /// Default socket number for DNS (UDP socket)
   static constexpr uint8_t kDNSSocket = 1;
 
-  /// Buffer size for DNS messages
-  static constexpr uint16_t kDNSBufferSize = 256;
+  /// Hostname length, the hostname itself lives only in EEPROM
+  static constexpr uint8_t kMaxHostnameLength = 31;
+
+  /// Retransmission interval and attempts per query
+  static constexpr uint16_t kRetryMs = 2000;
+  static constexpr uint8_t kMaxAttempts = 3;
+
+  /// TTL clamp: no query storm for TTL 0, no millis() wrap for huge TTLs
+  static constexpr uint32_t kMinTtlS = 60;
+  static constexpr uint32_t kMaxTtlS = 86400;
+
+  /// Next try after a failed query
+  static constexpr uint32_t kFailRetryS = 60;
 
   /**
    * @brief Construct DNS client.
    * @param uart Optional UART for debug logging (can be nullptr).
    */
   explicit DNSClient(serial::Interface* uart = nullptr);
-  ~DNSClient() = default;
 
   /**
-   * @brief Initialize DNS client.
-   * Must be called before resolve().
+   * @brief Load the cached entry and open the socket.
+   * A refresh of a cached entry starts as soon as a DNS server is set.
    */
-  void init();
+  void begin();
 
   /**
    * @brief Set DNS server address.
-   * @param dns_ip 4-byte DNS server IP address.
+   * @param dns_ip 4-byte DNS server IP address (0.0.0.0: no queries).
    */
   void set_dns_server(const uint8_t* dns_ip);
 
   /**
-   * @brief Resolve hostname to IP address.
-   * @param hostname Domain name to resolve (e.g., "mqtt.example.com").
-   * @param ip_out Output buffer for 4-byte resolved IP.
-   * @return DNSResult indicating success or failure reason.
-   * @note This function blocks for up to 6 seconds on failure.
+   * @brief Set the hostname to resolve, stored in EEPROM.
+   * Drops the cached address and starts a query.
+   * @param hostname Domain name (e.g., "mqtt.example.com"), empty to disable.
+   */
+  DNSResult set_hostname(const char* hostname);
+
+  /**
+   * @brief Run the resolver.
+   * Call this repeatedly in main loop while the network is up.
+   * @param rx_ready false: skip the RX buffer (EmbeddedSocketW5500::poll()
+   *        reported no RECV on kDNSSocket), only timers run.
+   * @return true once after the resolved address changed.
+   */
+  bool run(bool rx_ready = true);
+
+  /**
+   * @brief Query now unless a query is running or the last one was < 30 s ago.
+   * For callers that suspect a stale address (e.g. connect failures).
    */
-  DNSResult resolve(const char* hostname, uint8_t* ip_out);
+  void refresh();
 
   /**
-   * @brief Get last resolved IP address.
+   * @brief Get the cached address.
    * @param ip_out Output buffer for 4-byte IP.
-   * @return true if last resolution was successful.
+   * @return true if a hostname is set and it was resolved (now or before the reboot).
    */
-  bool get_last_ip(uint8_t* ip_out) const;
+  bool get_ip(uint8_t* ip_out) const;
+
+  bool has_hostname() const { return has_hostname_; }
 
   /**
-   * @brief Check if DNS client is initialized.
-   * @return true if init() was called.
+   * @brief Handle "dns ..." console commands.
+   * @return true if the command was a dns command.
    */
-  bool is_initialized() const;
+  bool process_command(const char* command);
 
  private:
+  static constexpr uint16_t kMinRefreshMs = 30000;
+
   serial::Interface* uart_;
 
-  uint8_t dns_buffer_[kDNSBufferSize];
   uint8_t dns_server_[4];
-  uint8_t last_ip_[4];
-  bool initialized_;
-  bool has_result_;
+  uint8_t ip_[4];
+  uint32_t ttl_s_;
+  uint32_t refresh_s_;  // Next query this long after last_query_ms_
+  uint32_t last_query_ms_;
+  uint32_t last_send_ms_;
+  uint16_t query_id_;
+  uint8_t attempts_;
+  bool has_hostname_;
+  bool querying_;
+  bool open_;
+
+  void start_query();
+  void send_query();
+  bool receive_answer(uint8_t* ip, uint32_t& ttl);
+  void query_failed();
 
   /**
    * @brief Log message to UART if available.
-   * @param message Message to log.
+   * @param progmem_text Message in flash.
    */
-  void log(const char* message);
+  void log(const char* progmem_text);
 
   /**
    * @brief Log IP address to UART.
-   * @param label Label for the IP.
+   * @param progmem_label Label for the IP, in flash.
    * @param ip IP address bytes.
    */
-  void log_ip(const char* label, const uint8_t* ip);
+  void log_ip(const char* progmem_label, const uint8_t* ip);
 };
 
 }  // namespace SmartBell
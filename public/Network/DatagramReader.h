@@ -0,0 +1,83 @@
+#ifndef PUBLIC_NETWORK_DATAGRAMREADER_H_
+#define PUBLIC_NETWORK_DATAGRAMREADER_H_
+
+#include <stdint.h>
+
+extern "C" {
+#include "W5500/w5500.h"
+}
+
+namespace SmartBell {
+
+/**
+ * @brief Reads one UDP datagram from a W5500 socket RX buffer through a small
+ * stack chunk, so DHCP and DNS replies are parsed without a packet buffer.
+ *
+ * The 8 byte W5500 UDP header (source ip, port, length) must already be read.
+ */
+class DatagramReader {
+ public:
+  static constexpr uint8_t kChunkSize = 16;
+
+  DatagramReader(uint8_t socket, uint16_t length)
+      : socket_(socket), left_(length), pos_(0), fill_(0) {}
+
+  bool read(uint8_t& byte) {
+    if (pos_ == fill_) {
+      if (left_ == 0) {
+        return false;
+      }
+      fill_ = (left_ < sizeof(chunk_)) ? left_ : sizeof(chunk_);
+      wiz_recv_data(socket_, chunk_, fill_);
+      left_ -= fill_;
+      pos_ = 0;
+    }
+    byte = chunk_[pos_++];
+    return true;
+  }
+
+  bool read(uint8_t* out, uint8_t length) {
+    for (uint8_t i = 0; i < length; i++) {
+      if (!read(out[i])) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  void skip(uint16_t length) {
+    uint8_t buffered = fill_ - pos_;
+    if (length <= buffered) {
+      pos_ += length;
+      return;
+    }
+    length -= buffered;
+    pos_ = fill_;
+    if (length > left_) {
+      length = left_;
+    }
+    wiz_recv_ignore(socket_, length);
+    left_ -= length;
+  }
+
+  // Drops the rest of the datagram and frees it in the W5500
+  void finish() {
+    if (left_ > 0) {
+      wiz_recv_ignore(socket_, left_);
+    }
+    setSn_CR(socket_, Sn_CR_RECV);
+    while (getSn_CR(socket_)) {
+    }
+  }
+
+ private:
+  uint8_t chunk_[kChunkSize];
+  uint8_t socket_;
+  uint16_t left_;
+  uint8_t pos_;
+  uint8_t fill_;
+};
+
+}  // namespace SmartBell
+
+#endif  // PUBLIC_NETWORK_DATAGRAMREADER_H_
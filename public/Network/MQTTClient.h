@@ -213,9 +213,7 @@ class MQTTClient {
   // Message callback
   MQTTMessageCallback default_callback_;
 
-  // Internal client structures (opaque - allocated on first use)
-  void* mqtt_client_;  // MQTTClient*
-  void* network_;      // Network*
+  // The ioLibrary MQTTClient / Network structures are static in MQTTClient.cpp
   bool initialized_;
 
   /**
@@ -0,0 +1,95 @@
+#ifndef PUBLIC_NETWORK_RINGGROUPNODE_H_
+#define PUBLIC_NETWORK_RINGGROUPNODE_H_
+
+#include <stdint.h>
+#include "Network/RingGroupProtocol.h"
+
+namespace serial {
+class Interface;
+}  // namespace serial
+
+namespace Network {
+
+/**
+ * @brief Broker-independent ring fan-out between bells via UDP multicast.
+ *
+ * Bells configured with the same group number and key trigger each other's
+ * gongs directly in one LAN hop. Every local press is sent as a signed
+ * 16 byte datagram to 239.255.42.1:4242; received datagrams are verified,
+ * deduplicated per sender and handed to the ring callback. MQTT is not
+ * involved, the broker can be down.
+ *
+ * Group, key and a boot epoch live in their own EEPROM record (the key is
+ * never held in SRAM). The socket stays closed until "ring key" has stored a
+ * key: the erased EEPROM key (all 0xFF) is public. The epoch forms the upper
+ * 16 bits of the sequence number, so sequences keep increasing across reboots.
+ * The highest sequence accepted per sender is persisted too, so a reboot of
+ * the receiver does not reopen the replay window (see RingGroup::DedupeWindow).
+ *
+ * Uses W5500 socket 4, ~50 bytes SRAM.
+ */
+class RingGroupNode {
+ public:
+  static constexpr uint8_t kSocketNumber = 4;
+  static constexpr uint16_t kPort = 4242;
+
+  // Called for every accepted ring from another bell
+  using RingCallback = void (*)(uint8_t gong_mask);
+
+  explicit RingGroupNode(serial::Interface& uart);
+
+  /**
+   * @brief Load the EEPROM record and join the multicast group if enabled.
+   * @param mac Own MAC address (last two bytes are the sender id).
+   * @param callback Ring callback.
+   * @return true if the group is enabled and the socket is open.
+   */
+  bool begin(const uint8_t* mac, RingCallback callback);
+
+  /**
+   * @brief Leave the group and close the socket.
+   */
+  void end();
+
+  /**
+   * @brief Send a ring to the group.
+   * @param gong_mask Bit n: ring gong n + 1 at the receivers.
+   */
+  bool send_ring(uint8_t gong_mask);
+
+  /**
+   * @brief Receive and dispatch all pending datagrams.
+   * Enough to call when EmbeddedSocketW5500::poll() reports kSocketNumber.
+   */
+  void loop();
+
+  /**
+   * @brief Handle "ring ..." console commands.
+   * @return true if the command was a ring command.
+   */
+  bool process_command(const char* command);
+
+  bool is_enabled() const { return open_; }
+
+ private:
+  bool open_socket();
+  void read_key(uint8_t* key);
+  void save_record();
+  void restore_floors();
+  void save_floors();
+  void advance_epoch();
+  void msg_ptr(const char* progmem_text);
+
+  serial::Interface* uart_;
+  RingCallback callback_;
+  RingGroup::DedupeWindow dedupe_;
+  uint32_t sequence_;  // epoch << 16 | counter
+  uint16_t sender_;
+  uint8_t group_;  // 0 = disabled
+  bool key_set_;   // "ring key" was used, otherwise the group stays closed
+  bool open_;
+};
+
+}  // namespace Network
+
+#endif  // PUBLIC_NETWORK_RINGGROUPNODE_H_
@@ -0,0 +1,110 @@
+#ifndef PUBLIC_NETWORK_RINGGROUPPROTOCOL_H_
+#define PUBLIC_NETWORK_RINGGROUPPROTOCOL_H_
+
+#include <stdint.h>
+
+namespace Network {
+namespace RingGroup {
+
+// Datagram layout (16 bytes, big endian):
+//   'R' 'G' | version | group | sender(2) | gong mask | flags | sequence(4) | tag(4)
+constexpr uint8_t kMagic0 = 'R';
+constexpr uint8_t kMagic1 = 'G';
+constexpr uint8_t kVersion = 1;
+constexpr uint8_t kDatagramLength = 16;
+constexpr uint8_t kSignedLength = 12;  // Everything in front of the tag
+constexpr uint8_t kTagLength = 4;
+constexpr uint8_t kKeyLength = 16;
+
+// Dedupe state
+constexpr uint8_t kMaxPeers = 4;       // Bells tracked at the same time
+constexpr uint8_t kDedupeWindow = 8;   // Sequences below the highest still accepted once
+
+/**
+ * @brief Decoded ring datagram.
+ */
+struct Datagram {
+  uint8_t group;      // Ring group, receivers ignore other groups
+  uint16_t sender;    // Sender id (last two MAC bytes)
+  uint8_t gong_mask;  // Bit n: ring gong n + 1
+  uint32_t sequence;  // Strictly increasing per sender, also across reboots
+};
+
+/**
+ * @brief Serialize and sign a datagram.
+ * @param datagram Fields to send.
+ * @param key 128-bit group key.
+ * @param out kDatagramLength bytes.
+ */
+void encode(const Datagram& datagram, const uint8_t* key, uint8_t* out);
+
+/**
+ * @brief Check magic, version and tag, then deserialize.
+ * @return false for foreign, truncated or forged datagrams.
+ */
+bool decode(const uint8_t* data, uint16_t length, const uint8_t* key, Datagram& datagram);
+
+/**
+ * @brief Truncated XTEA CBC-MAC over the kSignedLength header bytes.
+ *
+ * The datagram length is fixed, so plain CBC-MAC is sound here. XTEA only
+ * needs 32-bit adds, shifts and XORs - cheap on AVR compared to SHA-256 HMAC.
+ */
+void compute_tag(const uint8_t* data, const uint8_t* key, uint8_t* tag);
+
+/**
+ * @brief Per-sender replay/duplicate filter with a sliding window.
+ *
+ * Tracks the highest sequence per sender plus a bitmap of the kDedupeWindow
+ * sequences below it, so reordered datagrams are accepted exactly once and
+ * replays are dropped in O(1) per datagram.
+ *
+ * Replay window: the table itself is RAM only. RingGroupNode persists the
+ * highest sequence per slot and seeds it back with restore() after a reboot,
+ * so a captured datagram stays rejected across receiver resets. A sender that
+ * is not in the table is accepted with any sequence (there is no shared
+ * clock to judge freshness). With more than kMaxPeers bells in one group an
+ * evicted bell is forgotten, and one old datagram of it can be replayed once.
+ * Forging a new sender id needs the group key.
+ */
+class DedupeWindow {
+ public:
+  DedupeWindow();
+
+  /**
+   * @brief Record a sequence number.
+   * @return true if it was not seen before (datagram should be handled).
+   */
+  bool accept(uint16_t sender, uint32_t sequence);
+
+  /**
+   * @brief Seed a sender with a persisted floor: @p floor and everything
+   * below it count as already seen.
+   */
+  void restore(uint16_t sender, uint32_t floor);
+
+  /**
+   * @brief Slot @p index for persisting.
+   * @return false if the slot is unused.
+   */
+  bool peer(uint8_t index, uint16_t& sender, uint32_t& highest) const;
+
+ private:
+  struct Peer {
+    uint32_t highest;
+    uint16_t sender;
+    uint8_t seen;  // Bit n: highest - 1 - n was received
+    bool used;
+  };
+
+  // Slot of @p sender, or a free / round robin slot that is reset for it
+  Peer* claim(uint16_t sender, bool& known);
+
+  Peer peers_[kMaxPeers];
+  uint8_t next_victim_;  // Round robin replacement when all slots are used
+};
+
+}  // namespace RingGroup
+}  // namespace Network
+
+#endif  // PUBLIC_NETWORK_RINGGROUPPROTOCOL_H_
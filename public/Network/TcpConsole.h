@@ -0,0 +1,77 @@
+#ifndef PUBLIC_NETWORK_TCPCONSOLE_H_
+#define PUBLIC_NETWORK_TCPCONSOLE_H_
+
+#include <stdint.h>
+#include "Serial/Interface.h"
+
+namespace Network {
+
+/**
+ * @brief Telnet-style TCP console mirroring the UART console.
+ *
+ * Listens for one client on W5500 socket 5, port 23. As a serial::Interface
+ * it sits between LightweightConfig and the UART: all output goes to the UART
+ * and, while a client is connected, into the socket TX buffer. Input reads
+ * come from the socket, so the main loop feeds received lines into the same
+ * command parser as UART lines.
+ *
+ * Output is gathered in a kTxChunkLength buffer and sent on a full chunk, a
+ * line end or the next loop(), so the W5500 sees one SEND per line instead of
+ * one per byte. Chunks go straight into the socket TX buffer; while a SEND
+ * still waits for SENDOK they collect there and leave with the next one. Only
+ * a client that stops reading until the TX buffer is full loses output.
+ * Plain TCP, no telnet option negotiation; use a client with local echo (nc,
+ * telnet in line mode).
+ */
+class TcpConsole : public serial::Interface {
+ public:
+  static constexpr uint8_t kSocketNumber = 5;
+  static constexpr uint16_t kPort = 23;
+  static constexpr uint8_t kTxChunkLength = 32;
+
+  /**
+   * @param uart Console output is always mirrored here.
+   */
+  explicit TcpConsole(serial::Interface& uart);
+
+  /**
+   * @brief Open the listening socket. Needs an initialized W5500.
+   */
+  bool begin();
+
+  /**
+   * @brief Accept/close clients and flush pending output.
+   */
+  void loop();
+
+  /**
+   * @brief Drop the client without FIN (e.g. link lost) and listen again.
+   */
+  void drop_client();
+
+  bool is_client_connected() const { return connected_; }
+
+  void send(const uint8_t byte) override;
+  void send_bytes(const uint8_t* const bytes, const uint16_t length) override;
+  void send_string(const char* string) override;
+  using Interface::send_string;
+  bool is_read_data_available() const override;
+  uint8_t read_byte() override;
+
+ private:
+  void listen_socket();
+  void flush();
+  void service_send();
+
+  serial::Interface* uart_;
+  uint8_t tx_[kTxChunkLength];
+  uint8_t tx_length_;
+  uint16_t tx_unsent_;  // In the TX buffer, not yet covered by a SEND
+  bool send_in_flight_;
+  bool connected_;
+  bool open_;
+};
+
+}  // namespace Network
+
+#endif  // PUBLIC_NETWORK_TCPCONSOLE_H_
@@ -3,6 +3,8 @@
 
 #include <stdint.h>
 
+#include "Utils/FlashString.h"
+
 namespace serial {
 
 class Interface
@@ -13,6 +15,14 @@ class Interface
   virtual void send(const uint8_t byte) {}
   virtual void send_bytes(const uint8_t *const bytes, const uint16_t length) {}
   virtual void send_string(const char *string) {}
+  /// String from flash (FSTR / PROGMEM), sent byte by byte without an SRAM copy.
+  /// Derived classes pull this in with `using Interface::send_string;`
+  void send_string(const Utils::FlashString *string) {
+    char c;
+    for (uint16_t i = 0; (c = Utils::flash_char(string, i)) != '\0'; i++) {
+      send(static_cast<uint8_t>(c));
+    }
+  }
   virtual bool is_read_data_available() const { return 0; }
   virtual uint8_t read_byte() { return 0; }
 };
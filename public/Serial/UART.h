@@ -69,6 +69,7 @@ class UART : public Interface {
   void send(const uint8_t byte) override;
   void send_bytes(const uint8_t *const bytes, const uint16_t length) override;
   void send_string(const char *string) override;
+  using Interface::send_string;
   bool is_read_data_available() const override;
   uint8_t read_byte() override;
 
@@ -0,0 +1,71 @@
+#ifndef PUBLIC_SYSTEM_EVENTENVELOPE_H_
+#define PUBLIC_SYSTEM_EVENTENVELOPE_H_
+
+#include <stdint.h>
+
+namespace System {
+
+// Event payload layout (8 bytes, big endian):
+//   boot id(2) | sequence(4) | press age ms(2)
+constexpr uint8_t kEventEnvelopeLength = 8;
+
+/**
+ * @brief Delivery metadata attached to every published button event.
+ *
+ * (boot_id, sequence) identifies a press uniquely per device. Retries and
+ * QoS 1 retransmissions carry the same pair, so consumers can drop
+ * duplicates with a single comparison (see EventDedupe).
+ */
+struct EventEnvelope {
+  uint16_t boot_id;   // Incremented on every power-on, persisted in EEPROM
+  uint32_t sequence;  // Per boot id, survives watchdog resets
+  uint16_t age_ms;    // Press to publish, saturates at 0xFFFF
+};
+
+inline void encode_event(const EventEnvelope& event, uint8_t* out) {
+  out[0] = (event.boot_id >> 8) & 0xFF;
+  out[1] = event.boot_id & 0xFF;
+  out[2] = (event.sequence >> 24) & 0xFF;
+  out[3] = (event.sequence >> 16) & 0xFF;
+  out[4] = (event.sequence >> 8) & 0xFF;
+  out[5] = event.sequence & 0xFF;
+  out[6] = (event.age_ms >> 8) & 0xFF;
+  out[7] = event.age_ms & 0xFF;
+}
+
+inline bool decode_event(const uint8_t* data, uint16_t length, EventEnvelope& event) {
+  if (length != kEventEnvelopeLength) {
+    return false;
+  }
+  event.boot_id = (static_cast<uint16_t>(data[0]) << 8) | data[1];
+  event.sequence = (static_cast<uint32_t>(data[2]) << 24) | (static_cast<uint32_t>(data[3]) << 16) |
+                   (static_cast<uint32_t>(data[4]) << 8) | data[5];
+  event.age_ms = (static_cast<uint16_t>(data[6]) << 8) | data[7];
+  return true;
+}
+
+/**
+ * @brief Consumer side reference: O(1) duplicate filter for one device.
+ *
+ * Keeps only the newest (boot_id, sequence). A different boot id starts a
+ * new sequence space, a sequence at or below the newest one is a duplicate.
+ */
+struct EventDedupe {
+  uint16_t boot_id = 0;
+  uint32_t sequence = 0;
+  bool valid = false;
+
+  bool accept(const EventEnvelope& event) {
+    if (valid && event.boot_id == boot_id && event.sequence <= sequence) {
+      return false;
+    }
+    boot_id = event.boot_id;
+    sequence = event.sequence;
+    valid = true;
+    return true;
+  }
+};
+
+}  // namespace System
+
+#endif  // PUBLIC_SYSTEM_EVENTENVELOPE_H_
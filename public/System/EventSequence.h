@@ -0,0 +1,42 @@
+#ifndef PUBLIC_SYSTEM_EVENTSEQUENCE_H_
+#define PUBLIC_SYSTEM_EVENTSEQUENCE_H_
+
+#include <stdint.h>
+#include "System/EventEnvelope.h"
+
+namespace System {
+
+/**
+ * @brief Per-device event counter for EventEnvelope.
+ *
+ * The counter lives in .noinit RAM and is not cleared by the startup code,
+ * so a watchdog or external reset continues the sequence. After power-on,
+ * brown-out or a failed integrity check a new boot id is taken from EEPROM
+ * and the sequence restarts at 0.
+ */
+class EventSequence {
+ public:
+  /**
+   * @brief Call once at startup.
+   * @param cold_boot true after power-on or brown-out reset (RAM content undefined).
+   */
+  static void init(bool cold_boot);
+
+  /**
+   * @brief Reserve the sequence number for a new event.
+   */
+  static uint32_t next();
+
+  static uint16_t boot_id();
+
+  /**
+   * @brief Build the envelope for an event.
+   * @param sequence Value from next(), reused for every retry of the event.
+   * @param age_ms Time since the press.
+   */
+  static EventEnvelope envelope(uint32_t sequence, uint32_t age_ms);
+};
+
+}  // namespace System
+
+#endif  // PUBLIC_SYSTEM_EVENTSEQUENCE_H_
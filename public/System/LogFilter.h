@@ -0,0 +1,105 @@
+#ifndef PUBLIC_SYSTEM_LOGFILTER_H_
+#define PUBLIC_SYSTEM_LOGFILTER_H_
+
+#include <stdint.h>
+
+#include "Serial/Interface.h"
+#include "System/TokenLog.h"
+
+/**
+ * Compile-time log levels per module: 0 off, 1 error, 2 warn, 3 info, 4 debug.
+ * SB_LOG_LEVEL sets the default, SB_LOG_LEVEL_<MODULE> overrides one module.
+ */
+#ifndef SB_LOG_LEVEL
+#define SB_LOG_LEVEL 3
+#endif
+#ifndef SB_LOG_LEVEL_MQTT
+#define SB_LOG_LEVEL_MQTT SB_LOG_LEVEL
+#endif
+#ifndef SB_LOG_LEVEL_NET
+#define SB_LOG_LEVEL_NET SB_LOG_LEVEL
+#endif
+#ifndef SB_LOG_LEVEL_CFG
+#define SB_LOG_LEVEL_CFG SB_LOG_LEVEL
+#endif
+#ifndef SB_LOG_LEVEL_BELL
+#define SB_LOG_LEVEL_BELL SB_LOG_LEVEL
+#endif
+#ifndef SB_LOG_LEVEL_APP
+#define SB_LOG_LEVEL_APP SB_LOG_LEVEL
+#endif
+
+namespace System {
+
+enum class LogModule : uint8_t { kMQTT = 0, kNET, kCFG, kBELL, kAPP };
+
+constexpr uint8_t kLogModuleCount = 5;
+
+enum class LogLevel : uint8_t { kOff = 0, kError, kWarn, kInfo, kDebug };
+
+constexpr uint8_t kLogLevels[kLogModuleCount] = {SB_LOG_LEVEL_MQTT, SB_LOG_LEVEL_NET,
+                                                 SB_LOG_LEVEL_CFG, SB_LOG_LEVEL_BELL,
+                                                 SB_LOG_LEVEL_APP};
+
+/**
+ * @brief True if call sites of @p module at @p level are built at all.
+ */
+constexpr bool log_compiled(LogModule module, LogLevel level) {
+  return level != LogLevel::kOff &&
+         static_cast<uint8_t>(level) <= kLogLevels[static_cast<uint8_t>(module)];
+}
+
+/// All modules that have anything compiled in
+constexpr uint8_t kLogMaskAll = (1 << kLogModuleCount) - 1;
+
+/**
+ * @brief Runtime override, one bit per LogModule. A cleared bit mutes the
+ * compiled sites of that module; nothing above the compiled level can be
+ * switched on. Not persisted, every boot starts with kLogMaskAll.
+ */
+extern uint8_t g_log_mask;
+
+inline bool log_active(LogModule module) {
+  return (g_log_mask & (1 << static_cast<uint8_t>(module))) != 0;
+}
+
+/**
+ * @brief Compiled and not muted. For lines built from several parts
+ * (topics, IPs); with a constant false the whole block is dropped.
+ */
+inline bool log_enabled(LogModule module, LogLevel level) {
+  return log_compiled(module, level) && log_active(module);
+}
+
+/**
+ * @brief Console command "log": "log" lists the modules, "log <module|all>
+ * on|off" changes g_log_mask.
+ * @return false if @p command is not a log command.
+ */
+bool process_log_command(const char* command, serial::Interface& out);
+
+}  // namespace System
+
+/**
+ * @brief SB_LOG with module and level: SB_LOG_AT(uart, kMQTT, kWarn, "...").
+ * Sites above the compiled level of the module are discarded by if constexpr,
+ * together with their format string.
+ */
+#define SB_LOG_AT(out, module, level, format, ...)                     \
+  do {                                                                 \
+    if constexpr (::System::log_compiled(::System::LogModule::module,  \
+                                         ::System::LogLevel::level)) { \
+      if (::System::log_active(::System::LogModule::module)) {         \
+        SB_LOG(out, format, ##__VA_ARGS__);                            \
+      }                                                                \
+    }                                                                  \
+  } while (0)
+
+#define SB_LOG_ERROR(out, module, format, ...) \
+  SB_LOG_AT(out, module, kError, format, ##__VA_ARGS__)
+#define SB_LOG_WARN(out, module, format, ...) SB_LOG_AT(out, module, kWarn, format, ##__VA_ARGS__)
+#define SB_LOG_INFO(out, module, format, ...) SB_LOG_AT(out, module, kInfo, format, ##__VA_ARGS__)
+#define SB_LOG_DEBUG(out, module, format, ...) \
+  SB_LOG_AT(out, module, kDebug, format, ##__VA_ARGS__)
+
+#endif  // PUBLIC_SYSTEM_LOGFILTER_H_
@@ -0,0 +1,46 @@
+#ifndef PUBLIC_SYSTEM_STACKMONITOR_H_
+#define PUBLIC_SYSTEM_STACKMONITOR_H_
+
+#include <stdint.h>
+
+#include "Serial/Interface.h"
+
+namespace System {
+
+/// Fill byte written from the end of .bss up to RAMEND before main()
+constexpr uint8_t kStackPaint = 0xC5;
+
+/**
+ * @brief SRAM layout at runtime, all sizes in bytes.
+ *
+ * The stack grows down from RAMEND towards the heap (or .bss without heap).
+ * stack_free_min is the number of still painted bytes above the heap end, i.e.
+ * how close the deepest call so far came to overwriting .bss.
+ */
+struct MemoryStats {
+  uint16_t data_size;
+  uint16_t bss_size;
+  uint16_t heap_used;       // 0 when built with NO_HEAP
+  uint16_t stack_free_now;  // heap end .. current SP
+  uint16_t stack_free_min;  // never touched since reset
+};
+
+/**
+ * @brief Length of the run of kStackPaint bytes starting at @p begin.
+ */
+uint16_t count_painted(const uint8_t* begin, const uint8_t* end);
+
+/**
+ * @brief Current values; all zero on the host.
+ */
+MemoryStats memory_stats();
+
+/**
+ * @brief Console command "mem": prints MemoryStats.
+ * @return false if @p command is not "mem".
+ */
+bool process_mem_command(const char* command, serial::Interface& out);
+
+}  // namespace System
+
+#endif  // PUBLIC_SYSTEM_STACKMONITOR_H_
@@ -0,0 +1,111 @@
+#ifndef PUBLIC_SYSTEM_TOKENLOG_H_
+#define PUBLIC_SYSTEM_TOKENLOG_H_
+
+#include <stdint.h>
+
+#include "Serial/Interface.h"
+#include "Utils/ProgmemStrings.h"
+
+namespace System {
+
+/// Starts a binary log frame in the UART stream (ASCII record separator,
+/// never part of a text log line)
+constexpr uint8_t kLogFrameStart = 0x1E;
+
+constexpr uint8_t kMaxLogArgs = 4;
+
+/// Start, length, token (3), timestamp (5) and arguments (5 each) as varints
+constexpr uint8_t kMaxLogFrameSize = 2 + 3 + 5 + kMaxLogArgs * 5;
+
+/**
+ * @brief Token of a log format string: 32 bit FNV-1a folded to 16 bit.
+ * tools/log_tokens.py computes the same value for its id table and fails on
+ * a collision.
+ */
+constexpr uint16_t log_token(const char* format) {
+  uint32_t hash = 2166136261UL;
+  while (*format != '\0') {
+    hash ^= static_cast<uint8_t>(*format++);
+    hash *= 16777619UL;
+  }
+  return static_cast<uint16_t>((hash >> 16) ^ (hash & 0xFFFF));
+}
+
+/// Forces log_token() into a constant, so the format string is not emitted
+template <uint16_t kToken>
+struct LogToken {
+  static constexpr uint16_t value = kToken;
+};
+
+/**
+ * @brief Argument as it is sent. Signed values are zigzag encoded, so small
+ * negative numbers stay short; log them with %d, everything else with %u / %x.
+ */
+template <typename T>
+constexpr uint32_t log_arg(T value) {
+  if (static_cast<T>(-1) < static_cast<T>(0)) {
+    int32_t v = static_cast<int32_t>(value);
+    return (static_cast<uint32_t>(v) << 1) ^ static_cast<uint32_t>(v >> 31);
+  }
+  return static_cast<uint32_t>(value);
+}
+
+/**
+ * @brief LEB128 varint, 1 to 5 bytes.
+ * @return Bytes written.
+ */
+uint8_t encode_varint(uint32_t value, uint8_t* out);
+
+/**
+ * @brief Build a log frame: kLogFrameStart, length of the rest, then token,
+ * timestamp and arguments as varints.
+ * @param out At least kMaxLogFrameSize bytes.
+ * @return Frame size in bytes.
+ */
+uint8_t encode_log_frame(uint16_t token, uint32_t timestamp_ms, const uint32_t* args,
+                         uint8_t arg_count, uint8_t* out);
+
+/**
+ * @brief Send a log frame with the current millis() to @p out (may be nullptr).
+ */
+void write_log_frame(serial::Interface* out, uint16_t token, const uint32_t* args,
+                     uint8_t arg_count);
+
+/**
+ * @brief Text fallback: print a PROGMEM format, %u %d %x take the next argument.
+ */
+void write_log_text(serial::Interface* out, const char* progmem_format, const uint32_t* args,
+                    uint8_t arg_count);
+
+template <typename... Args>
+inline void log_frame(serial::Interface* out, uint16_t token, Args... args) {
+  static_assert(sizeof...(Args) <= kMaxLogArgs, "Too many log arguments");
+  const uint32_t values[sizeof...(Args) + 1] = {log_arg(args)..., 0};
+  write_log_frame(out, token, values, sizeof...(Args));
+}
+
+template <typename... Args>
+inline void log_text(serial::Interface* out, const char* progmem_format, Args... args) {
+  static_assert(sizeof...(Args) <= kMaxLogArgs, "Too many log arguments");
+  const uint32_t values[sizeof...(Args) + 1] = {log_arg(args)..., 0};
+  write_log_text(out, progmem_format, values, sizeof...(Args));
+}
+
+}  // namespace System
+
+/**
+ * @brief Log a line: SB_LOG(uart, "[MQTT] Retry %u\r\n", count).
+ *
+ * With ENABLE_TOKEN_LOG only a 16 bit token of the format string goes into
+ * the firmware and a frame of a few bytes onto the wire; tools/log_tokens.py
+ * rebuilds the text from the token table generated at build time. Otherwise
+ * the format is printed from flash. @p format must be a string literal.
+ */
+#ifdef ENABLE_TOKEN_LOG
+#define SB_LOG(out, format, ...) \
+  ::System::log_frame(out, ::System::LogToken<::System::log_token(format)>::value, ##__VA_ARGS__)
+#else
+#define SB_LOG(out, format, ...) ::System::log_text(out, PSTR_STORED(format), ##__VA_ARGS__)
+#endif
+
+#endif  // PUBLIC_SYSTEM_TOKENLOG_H_
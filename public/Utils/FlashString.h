@@ -0,0 +1,81 @@
+#ifndef PUBLIC_UTILS_FLASHSTRING_H_
+#define PUBLIC_UTILS_FLASHSTRING_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#ifdef __AVR__
+#include <avr/pgmspace.h>
+#elif !defined(PROGMEM)
+#define PROGMEM
+#endif
+
+namespace Utils {
+
+/**
+ * @brief Marker type for strings in PROGMEM, never defined.
+ *
+ * On AVR a plain "literal" is copied to SRAM at startup. A
+ * `const FlashString*` instead points into flash and selects the overloads
+ * that read it with pgm_read_byte / memcpy_P (serial::Interface::send_string,
+ * MinimalMQTT::publish / subscribe). Create one with FSTR("...") or
+ * as_flash() for a PROGMEM array.
+ */
+class FlashString;
+
+inline const FlashString* as_flash(const char* progmem_text) {
+  return reinterpret_cast<const FlashString*>(progmem_text);
+}
+
+inline const char* progmem_ptr(const FlashString* text) {
+  return reinterpret_cast<const char*>(text);
+}
+
+#ifdef __AVR__
+inline size_t flash_strlen(const FlashString* text) { return strlen_P(progmem_ptr(text)); }
+
+inline size_t flash_strnlen(const FlashString* text, size_t max_length) {
+  return strnlen_P(progmem_ptr(text), max_length);
+}
+
+/// strcmp() of a RAM string against a flash string
+inline int flash_compare(const char* text, const FlashString* flash_text) {
+  return strcmp_P(text, progmem_ptr(flash_text));
+}
+
+inline void flash_copy(void* dest, const FlashString* text, size_t length) {
+  memcpy_P(dest, progmem_ptr(text), length);
+}
+
+inline char flash_char(const FlashString* text, size_t index) {
+  return static_cast<char>(pgm_read_byte(progmem_ptr(text) + index));
+}
+#else
+inline size_t flash_strlen(const FlashString* text) { return strlen(progmem_ptr(text)); }
+
+inline size_t flash_strnlen(const FlashString* text, size_t max_length) {
+  return strnlen(progmem_ptr(text), max_length);
+}
+
+inline int flash_compare(const char* text, const FlashString* flash_text) {
+  return strcmp(text, progmem_ptr(flash_text));
+}
+
+inline void flash_copy(void* dest, const FlashString* text, size_t length) {
+  memcpy(dest, progmem_ptr(text), length);
+}
+
+inline char flash_char(const FlashString* text, size_t index) { return progmem_ptr(text)[index]; }
+#endif
+
+}  // namespace Utils
+
+/// Literal in flash as a typed pointer: uart->send_string(FSTR("Ready\r\n"))
+#ifdef __AVR__
+#define FSTR(s) (::Utils::as_flash(PSTR(s)))
+#else
+#define FSTR(s) (::Utils::as_flash(s))
+#endif
+
+#endif  // PUBLIC_UTILS_FLASHSTRING_H_
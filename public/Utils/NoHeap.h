@@ -0,0 +1,14 @@
+#ifndef PUBLIC_UTILS_NOHEAP_H_
+#define PUBLIC_UTILS_NOHEAP_H_
+
+// Forced into every C++ translation unit with USE_HEAP=OFF (-include, see the
+// root CMakeLists.txt): any new-expression is a compile error at its call site.
+// Placement new is a different overload and stays usable.
+#if defined(NO_HEAP) && defined(__cplusplus)
+#include <stddef.h>
+
+void* operator new(size_t size) __attribute__((error("heap disabled (USE_HEAP=OFF)")));
+void* operator new[](size_t size) __attribute__((error("heap disabled (USE_HEAP=OFF)")));
+#endif
+
+#endif  // PUBLIC_UTILS_NOHEAP_H_
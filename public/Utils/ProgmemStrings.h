@@ -7,9 +7,13 @@
 #else
 // For non-AVR builds, PROGMEM strings are just regular strings
 #define PSTR_STORED(s) (s)
+#ifndef PROGMEM
 #define PROGMEM
+#endif
+#ifndef pgm_read_byte
 #define pgm_read_byte(addr) (*(addr))
 #endif
+#endif
 
 #include <stdint.h>
 #include "Serial/Interface.h"
@@ -42,7 +46,8 @@ inline void print_P(serial::Interface* uart, const char* pstr) {
 inline void println_P(serial::Interface* uart, const char* pstr) {
   print_P(uart, pstr);
   if (uart != nullptr) {
-    uart->send_string("\r\n");
+    uart->send('\r');
+    uart->send('\n');
   }
 }
 
@@ -7,6 +7,9 @@
 #include <avr/pgmspace.h>
 #endif
 
+// Fixed app lines are debug level; topics and payloads still go through log()
+#define APP_LOG(...) SB_LOG_DEBUG(uart_, kAPP, __VA_ARGS__)
+
 namespace App {
 
 // Static instance for callbacks
@@ -35,7 +38,7 @@ SmartBellApp::~SmartBellApp() {
 }
 
 void SmartBellApp::init() {
-  log("[APP] Init\r\n");
+  APP_LOG("[APP] Init\r\n");
 
   // MinimalMQTT initialization happens via constructor - no init() needed
   // No reconnect_interval setting - managed internally by state machine
@@ -105,7 +108,7 @@ void SmartBellApp::transition_to(AppState new_state) {
 
 #if SMARTBELL_VERBOSE_LOG
 void SmartBellApp::log_state_transition(AppState from, AppState to) {
-  log("[APP] State: ");
+  APP_LOG("[APP] State: ");
   log(state_name(from));
   log(" -> ");
   log(state_name(to));
@@ -144,7 +147,7 @@ void SmartBellApp::handle_init() {
 }
 
 void SmartBellApp::handle_config_check() {
-  log("[APP] Checking EEPROM configuration...\r\n");
+  APP_LOG("[APP] Checking EEPROM configuration...\r\n");
 
   // Try to load configuration from EEPROM
   if (config_manager_.load_from_eeprom()) {
@@ -152,16 +155,16 @@ void SmartBellApp::handle_config_check() {
     const Config::SmartBellConfig& cfg = config_manager_.get_config();
     if (cfg.mqtt_broker_ip[0] != 0 || cfg.mqtt_broker_ip[1] != 0 || cfg.mqtt_broker_ip[2] != 0 ||
         cfg.mqtt_broker_ip[3] != 0) {
-      log("[APP] Valid config loaded\r\n");
+      APP_LOG("[APP] Valid config loaded\r\n");
       transition_to(AppState::kNetworkInit);
     } else {
-      log("[APP] Invalid broker IP, entering config mode\r\n");
+      APP_LOG("[APP] Invalid broker IP, entering config mode\r\n");
       config_manager_.load_defaults();
       transition_to(AppState::kConfigMode);
     }
   } else {
     // EEPROM empty or corrupted - enter configuration mode
-    log("[APP] No valid config, entering config mode\r\n");
+    APP_LOG("[APP] No valid config, entering config mode\r\n");
     config_manager_.load_defaults();
     transition_to(AppState::kConfigMode);
   }
@@ -175,14 +178,14 @@ void SmartBellApp::handle_config_mode() {
   const Config::SmartBellConfig& cfg = config_manager_.get_config();
   if (cfg.mqtt_broker_ip[0] != 0 || cfg.mqtt_broker_ip[1] != 0 || cfg.mqtt_broker_ip[2] != 0 ||
       cfg.mqtt_broker_ip[3] != 0) {
-    log("[APP] Configuration complete\r\n");
+    APP_LOG("[APP] Configuration complete\r\n");
     config_manager_.save_to_eeprom();
     transition_to(AppState::kNetworkInit);
   }
 }
 
 void SmartBellApp::handle_network_init() {
-  log("[APP] Configuring static IP...\r\n");
+  APP_LOG("[APP] Configuring static IP...\r\n");
 
   // Get configuration
   const Config::SmartBellConfig& cfg = config_manager_.get_config();
@@ -200,21 +203,30 @@ void SmartBellApp::handle_network_init() {
   w5500_->set_subnet(&subnet);
   w5500_->set_gateway(&gateway);
 
-  log("[APP] Network configured, connecting to MQTT...\r\n");
+  APP_LOG("[APP] Network configured, connecting to MQTT...\r\n");
   transition_to(AppState::kMQTTConnecting);
 }
 
 void SmartBellApp::handle_mqtt_connecting() {
-  log("[APP] MQTT Connecting...\r\n");
+  APP_LOG("[APP] MQTT Connecting...\r\n");
 
   // Build MQTT::Config from ConfigManager
   const Config::SmartBellConfig& cfg = config_manager_.get_config();
-  MQTT::Config mqtt_cfg;
+  MQTT::Config mqtt_cfg{};
   memcpy(mqtt_cfg.broker_ip, cfg.mqtt_broker_ip, 4);
   mqtt_cfg.broker_port = cfg.mqtt_port;
   strncpy(mqtt_cfg.client_id, cfg.mqtt_client_id, sizeof(mqtt_cfg.client_id) - 1);
   mqtt_cfg.client_id[sizeof(mqtt_cfg.client_id) - 1] = '\0';
   mqtt_cfg.keepalive = cfg.mqtt_keepalive;
+  mqtt_cfg.clean_session = true;
+
+  // Retained presence: broker publishes "offline" when keepalive runs out
+  mqtt_cfg.will_topic = SmartBellTopics::kStatus;
+  mqtt_cfg.will_payload = MQTT::kPresenceOffline;
+  mqtt_cfg.birth_payload = MQTT::kPresenceOnline;
+  mqtt_cfg.presence_in_flash = true;
+  mqtt_cfg.will_qos = MQTT::QoS::kAtLeastOnce;
+  mqtt_cfg.will_retain = true;
 
   // Set credentials if configured
   if (cfg.mqtt_username[0] != '\0') {
@@ -234,7 +246,7 @@ void SmartBellApp::handle_mqtt_connecting() {
 
     transition_to(AppState::kRunning);
   } else {
-    log("[APP] MQTT connection failed\r\n");
+    APP_LOG("[APP] MQTT connection failed\r\n");
     reconnect_start_time_ = System::TimerService::seconds();
     transition_to(AppState::kReconnectWait);
   }
@@ -252,7 +264,7 @@ void SmartBellApp::handle_running() {
 
   // Check if connection was lost
   if (!mqtt_client_.is_connected()) {
-    log("[APP] MQTT connection lost\r\n");
+    APP_LOG("[APP] MQTT connection lost\r\n");
     reconnect_start_time_ = System::TimerService::seconds();
     transition_to(AppState::kReconnectWait);
   }
@@ -267,7 +279,7 @@ void SmartBellApp::handle_reconnect_wait() {
   uint32_t elapsed = System::TimerService::seconds() - reconnect_start_time_;
 
   if (elapsed >= kReconnectIntervalSec) {
-    log("[APP] Reconnect interval elapsed, retrying...\r\n");
+    APP_LOG("[APP] Reconnect interval elapsed, retrying...\r\n");
     transition_to(AppState::kMQTTConnecting);
   }
 
@@ -282,7 +294,7 @@ void SmartBellApp::handle_error() {
   uint32_t now = System::TimerService::seconds();
 
   if (now - last_error_log >= 10) {
-    log("[APP] In error state, attempting recovery...\r\n");
+    APP_LOG("[APP] In error state, attempting recovery...\r\n");
     last_error_log = now;
 
     // Try to recover by re-initializing network
@@ -308,9 +320,9 @@ void SmartBellApp::process_button_events() {
       // On button release (transition to inactive), trigger gongs
       if (!active) {
         gong_controller_.trigger(GongId::kBoth);
-        log("[APP] Frontdoor released, triggering gongs\r\n");
+        APP_LOG("[APP] Frontdoor released, triggering gongs\r\n");
       } else {
-        log("[APP] Frontdoor pressed\r\n");
+        APP_LOG("[APP] Frontdoor pressed\r\n");
       }
 
       frontdoor_button_.last_state = current;
@@ -331,9 +343,9 @@ void SmartBellApp::process_button_events() {
 
       if (!active) {
         gong_controller_.trigger(GongId::kBoth);
-        log("[APP] Office released, triggering gongs\r\n");
+        APP_LOG("[APP] Office released, triggering gongs\r\n");
       } else {
-        log("[APP] Office pressed\r\n");
+        APP_LOG("[APP] Office pressed\r\n");
       }
 
       office_button_.last_state = current;
@@ -342,36 +354,49 @@ void SmartBellApp::process_button_events() {
 }
 
 void SmartBellApp::publish_button_event(ButtonId button, bool active) {
-  const char* topic;
-
+  // Topic is fixed, so the whole PUBLISH header (empty payload) is built at
+  // compile time - the topic itself indicates the event
+  // Queued as ring events: flushed ahead of everything else on the next loop()
+  constexpr MQTT::Priority kEventPriority = MQTT::Priority::kRing;
+  constexpr MQTT::QoS kEventQoS = MQTT::QoS::kAtLeastOnce;
+  bool published;
   if (button == ButtonId::kFrontdoor) {
-    topic = active ? SmartBellTopics::kFrontdoorActive : SmartBellTopics::kFrontdoorInactive;
+    if (active) {
+      constexpr MQTT::PreparedPublish kPacket =
+          MQTT::make_prepared_publish_P(SmartBellTopics::kFrontdoorActive, 0);
+      published = mqtt_client_.queue_publish(kPacket, nullptr, kEventPriority, kEventQoS);
+    } else {
+      constexpr MQTT::PreparedPublish kPacket =
+          MQTT::make_prepared_publish_P(SmartBellTopics::kFrontdoorInactive, 0);
+      published = mqtt_client_.queue_publish(kPacket, nullptr, kEventPriority, kEventQoS);
+    }
   } else {
-    topic = active ? SmartBellTopics::kOfficeActive : SmartBellTopics::kOfficeInactive;
+    if (active) {
+      constexpr MQTT::PreparedPublish kPacket =
+          MQTT::make_prepared_publish_P(SmartBellTopics::kOfficeActive, 0);
+      published = mqtt_client_.queue_publish(kPacket, nullptr, kEventPriority, kEventQoS);
+    } else {
+      constexpr MQTT::PreparedPublish kPacket =
+          MQTT::make_prepared_publish_P(SmartBellTopics::kOfficeInactive, 0);
+      published = mqtt_client_.queue_publish(kPacket, nullptr, kEventPriority, kEventQoS);
+    }
   }
 
-  // Publish with empty payload (topic itself indicates the event)
-  const uint8_t empty_payload = 0;
-  if (mqtt_client_.publish(topic, &empty_payload, 0)) {
-    log("[APP] Button event published\r\n");
+  if (published) {
+    APP_LOG("[APP] Button event queued\r\n");
   } else {
-    log("[APP] Failed to publish button event\r\n");
+    APP_LOG("[APP] Failed to queue button event\r\n");
   }
 }
 
 void SmartBellApp::subscribe_to_topics() {
-  log("[APP] Subscribing to topics...\r\n");
-
-  // MinimalMQTT supports max 2 subscriptions with single callback
-  // For multiple topics, use wildcard or handle in callback
-  // Subscribe to test gong topics (most important for user interaction)
-  mqtt_client_.subscribe(SmartBellTopics::kTestGongUpperfloor, on_mqtt_message);
-  mqtt_client_.subscribe(SmartBellTopics::kTestGongBoth, on_mqtt_message);
+  APP_LOG("[APP] Subscribing to topics...\r\n");
 
-  // Note: Limited to 2 subscriptions - gong status, groundfloor, duration topics not subscribed
-  // Consider MQTT topic wildcards (e.g., "smartbell/gong/#") if broker supports
+  // One wildcard slot covers testgong, duration and status topics,
+  // on_mqtt_message dispatches on the full topic
+  mqtt_client_.subscribe(Utils::as_flash(SmartBellTopics::kGongControlFilter), on_mqtt_message);
 
-  log("[APP] Subscribed to critical topics\r\n");
+  APP_LOG("[APP] Subscribed to gong topics\r\n");
 }
 
 void SmartBellApp::on_mqtt_message(const char* topic, const uint8_t* payload,
@@ -398,35 +423,43 @@ void SmartBellApp::process_mqtt_message(const char* topic, const uint8_t* payloa
     }
   }
 
-  log("[APP] MQTT: ");
+  APP_LOG("[APP] MQTT: ");
   log(topic);
   log(" = ");
   log(payload_str);
   log("\r\n");
 
   // Handle gong status topics
-  if (strcmp(topic, SmartBellTopics::kGongUpperfloorStatus) == 0) {
-    bool enabled = (strncmp(payload_str, "active", 6) == 0);
+  if (strcmp_P(topic, SmartBellTopics::kGongUpperfloorStatus) == 0) {
+    bool enabled = (strncmp_P(payload_str, PSTR("active"), 6) == 0);
     gong_controller_.set_enabled(GongId::kUpperfloor, enabled);
-    log(enabled ? "[APP] Upperfloor gong enabled\r\n" : "[APP] Upperfloor gong disabled\r\n");
-  } else if (strcmp(topic, SmartBellTopics::kGongGroundfloorStatus) == 0) {
-    bool enabled = (strncmp(payload_str, "active", 6) == 0);
+    if (enabled) {
+      APP_LOG("[APP] Upperfloor gong enabled\r\n");
+    } else {
+      APP_LOG("[APP] Upperfloor gong disabled\r\n");
+    }
+  } else if (strcmp_P(topic, SmartBellTopics::kGongGroundfloorStatus) == 0) {
+    bool enabled = (strncmp_P(payload_str, PSTR("active"), 6) == 0);
     gong_controller_.set_enabled(GongId::kGroundfloor, enabled);
-    log(enabled ? "[APP] Groundfloor gong enabled\r\n" : "[APP] Groundfloor gong disabled\r\n");
+    if (enabled) {
+      APP_LOG("[APP] Groundfloor gong enabled\r\n");
+    } else {
+      APP_LOG("[APP] Groundfloor gong disabled\r\n");
+    }
   }
   // Handle test gong topics (trigger regardless of payload)
-  else if (strcmp(topic, SmartBellTopics::kTestGongUpperfloor) == 0) {
+  else if (strcmp_P(topic, SmartBellTopics::kTestGongUpperfloor) == 0) {
     gong_controller_.trigger(GongId::kUpperfloor, true);  // force=true ignores enabled state
-    log("[APP] Test gong upperfloor\r\n");
-  } else if (strcmp(topic, SmartBellTopics::kTestGongGroundfloor) == 0) {
+    APP_LOG("[APP] Test gong upperfloor\r\n");
+  } else if (strcmp_P(topic, SmartBellTopics::kTestGongGroundfloor) == 0) {
     gong_controller_.trigger(GongId::kGroundfloor, true);
-    log("[APP] Test gong groundfloor\r\n");
-  } else if (strcmp(topic, SmartBellTopics::kTestGongBoth) == 0) {
+    APP_LOG("[APP] Test gong groundfloor\r\n");
+  } else if (strcmp_P(topic, SmartBellTopics::kTestGongBoth) == 0) {
     gong_controller_.trigger(GongId::kBoth, true);
-    log("[APP] Test gong both\r\n");
+    APP_LOG("[APP] Test gong both\r\n");
   }
   // Handle duration configuration
-  else if (strcmp(topic, SmartBellTopics::kGongDuration) == 0) {
+  else if (strcmp_P(topic, SmartBellTopics::kGongDuration) == 0) {
     // Parse number from payload
     uint16_t duration = 0;
     for (uint16_t i = 0; i < copy_len; i++) {
@@ -440,14 +473,14 @@ void SmartBellApp::process_mqtt_message(const char* topic, const uint8_t* payloa
     }
     if (duration >= 100 && duration <= 10000) {
       gong_controller_.set_duration(duration);
-      log("[APP] Gong duration updated\r\n");
+      APP_LOG("[APP] Gong duration updated\r\n");
     }
   }
 }
 
 void SmartBellApp::log(const char* message) {
 #if SMARTBELL_VERBOSE_LOG
-  if (uart_ != nullptr) {
+  if (uart_ != nullptr && System::log_active(System::LogModule::kAPP)) {
     uart_->send_string(message);
   }
 #else
@@ -30,6 +30,8 @@
 #endif
 #include <avr/pgmspace.h>
 
+#include "System/LogFilter.h"
+
 extern "C" {
 extern const char smart_bell_flash_help[] __attribute__((__progmem__));
 }
@@ -166,7 +168,7 @@ void LightweightConfig::load() {
   eeprom_read_cfg(&temp, EEPROM_ADDR);
   if (is_valid_config(temp)) {
     memcpy(&config_, &temp, sizeof(SmartBellConfig));
-    msg_ptr(PSTR("[CFG] Loaded\r\n"));
+    SB_LOG_INFO(uart_, kCFG, "[CFG] Loaded\r\n");
     return;
   }
 
@@ -175,18 +177,18 @@ void LightweightConfig::load() {
   if (is_valid_config(temp)) {
     memcpy(&config_, &temp, sizeof(SmartBellConfig));
     eeprom_write_cfg(&config_, EEPROM_ADDR);
-    msg_ptr(PSTR("[CFG] Loaded (migrated)\r\n"));
+    SB_LOG_INFO(uart_, kCFG, "[CFG] Loaded (migrated)\r\n");
     return;
   }
 
-  msg_ptr(PSTR("[CFG] Invalid, using defaults\r\n"));
+  SB_LOG_WARN(uart_, kCFG, "[CFG] Invalid, using defaults\r\n");
 }
 
 void LightweightConfig::save() {
   config_.magic = MAGIC;
   eeprom_write_cfg(&config_, EEPROM_ADDR);
   save_flag_ = true;
-  msg_ptr(PSTR("[CFG] Saved\r\n"));
+  SB_LOG_INFO(uart_, kCFG, "[CFG] Saved\r\n");
 }
 
 // Manual IP parser: "192.168.1.100" → {192,168,1,100}
@@ -240,10 +242,19 @@ void LightweightConfig::print_ip(const uint8_t* ip) {
     buf[idx] = '\0';
     uart_->send_string(buf);
     if (i < 3)
-      uart_->send_string(".");
+      uart_->send('.');
   }
 }
 
+// Same parser, output temporarily redirected (e.g. to the MQTT console)
+bool LightweightConfig::process_command(const char* cmd, serial::Interface& output) {
+  serial::Interface* console = uart_;
+  uart_ = &output;
+  bool result = process_command(cmd);
+  uart_ = console;
+  return result;
+}
+
 // Simple command parser - erweiterte Version
 bool LightweightConfig::process_command(const char* cmd) {
   if (!cmd || !uart_)
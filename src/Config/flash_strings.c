@@ -3,15 +3,30 @@
 // Reine C-Definition im Flash
 const char smart_bell_flash_help[] __attribute__((__progmem__)) =
     "Commands:\r\n"
+#ifdef ENABLE_DHCP
+    "  ip <a.b.c.d>        - Set device IP (0.0.0.0 = DHCP, after reboot)\r\n"
+#else
     "  ip <a.b.c.d>        - Set device IP\r\n"
+#endif
     "  sn <a.b.c.d>        - Set subnet mask\r\n"
     "  gw <a.b.c.d>        - Set gateway\r\n"
     "  br <a.b.c.d>:<port> - Set broker IP and port\r\n"
+#ifdef ENABLE_DNS
+    "  dns host <name>     - Broker hostname (overrides broker IP), saved immediately\r\n"
+    "  dns [off]           - Show / clear broker hostname\r\n"
+#endif
     "  id <name>           - Set MQTT client ID\r\n"
     "  input 1 pt <name>   - Set publish topic for Bell Button 1\r\n"
     "  input 2 pt <name>   - Set publish topic for Bell Button 2\r\n"
     "  gong sub <name>     - Base topic Chime 1&2. Ex: <name>/1 (CMD: ON/OFF/RING)\r\n"
+#ifdef ENABLE_RING_GROUP
+    "  ring group <n>      - LAN ring group (0 = off), saved immediately\r\n"
+    "  ring key <32 hex>   - 128-bit group key, same on all bells\r\n"
+#endif
     "  show                - Show current configuration\r\n"
+    "  sockets             - W5500 buffer use and high-water mark per socket\r\n"
+    "  log [<mod> on|off]  - Log levels per module (mqtt net cfg bell app all)\r\n"
+    "  mem                 - .data/.bss/heap size and free stack (minimum since reset)\r\n"
     "  save                - Save configuration to EEPROM\r\n"
     "  reset               - Load factory defaults\r\n"
     "  reboot              - Restart the microcontroller\r\n";
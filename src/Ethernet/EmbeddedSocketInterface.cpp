@@ -8,6 +8,13 @@
 
 namespace Ethernet {
 
+namespace {
+
+// Sockets already enabled in SIMR / Sn_IMR by poll()
+uint8_t poll_enabled_mask = 0;
+
+}  // namespace
+
 EmbeddedSocketW5500::EmbeddedSocketW5500(const Ethernet::W5500Interface* const w5500_interface)
     : w5500_interface_(w5500_interface) {}
 
@@ -100,6 +107,33 @@ W5500SocketStatus EmbeddedSocketW5500::get_socket_status(uint8_t socket_num) con
   return socket_status_[socket_num];
 }
 
+uint8_t EmbeddedSocketW5500::poll(uint8_t mask, uint8_t* events) {
+  uint8_t new_sockets = mask & ~poll_enabled_mask;
+  if (new_sockets != 0) {
+    // SIR only reflects sockets enabled in SIMR, and only Sn_IR bits enabled in Sn_IMR
+    for (uint8_t sn = 0; sn < 8; sn++) {
+      if (new_sockets & (1 << sn)) {
+        setSn_IMR(sn, kPollEvents);
+      }
+    }
+    poll_enabled_mask |= new_sockets;
+    setSIMR(poll_enabled_mask);
+  }
+
+  uint8_t ready = getSIR() & mask;
+  for (uint8_t sn = 0; sn < 8; sn++) {
+    if ((ready & (1 << sn)) == 0) {
+      continue;
+    }
+    uint8_t ir = getSn_IR(sn) & kPollEvents;
+    setSn_IR(sn, ir);  // Write 1 to clear, SENDOK stays for send()
+    if (events != nullptr) {
+      events[sn] = ir;
+    }
+  }
+  return ready;
+}
+
 uint8_t EmbeddedSocketW5500::get_socket_index_(const W5500SocketNumber socket_num) const {
   return static_cast<uint8_t>(socket_num);
 }
@@ -0,0 +1,55 @@
+#include "Ethernet/LinkMonitor.h"
+
+#include <Ethernet/W5500/w5500.h>
+
+namespace Ethernet {
+
+LinkMonitor::LinkMonitor()
+    : last_poll_ms_(0),
+      down_since_ms_(0),
+      last_recovery_ms_(0),
+      link_down_count_(0),
+      up_(false),
+      recovering_(false) {}
+
+void LinkMonitor::begin(uint32_t now_ms) {
+  up_ = read_link();
+  last_poll_ms_ = now_ms;
+}
+
+LinkEvent LinkMonitor::run(uint32_t now_ms) {
+  if ((now_ms - last_poll_ms_) < kPollIntervalMs) {
+    return LinkEvent::kNone;
+  }
+  last_poll_ms_ = now_ms;
+
+  bool up = read_link();
+  if (up == up_) {
+    return LinkEvent::kNone;
+  }
+  up_ = up;
+
+  if (!up) {
+    // Only the first down of a flap series starts the outage
+    if (!recovering_) {
+      down_since_ms_ = now_ms;
+      recovering_ = true;
+    }
+    link_down_count_++;
+    return LinkEvent::kDown;
+  }
+  return LinkEvent::kUp;
+}
+
+bool LinkMonitor::mark_recovered(uint32_t now_ms) {
+  if (!recovering_ || !up_) {
+    return false;
+  }
+  recovering_ = false;
+  last_recovery_ms_ = now_ms - down_since_ms_;
+  return true;
+}
+
+bool LinkMonitor::read_link() { return (getPHYCFGR() & PHYCFGR_LNK_ON) != 0; }
+
+}  // namespace Ethernet
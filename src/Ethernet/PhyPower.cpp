@@ -0,0 +1,97 @@
+#include "Ethernet/PhyPower.h"
+
+#include <Ethernet/W5500/w5500.h>
+#include <Ethernet/wizchip_conf.h>
+
+namespace Ethernet {
+
+PhyPower::PhyPower(PhyProfile profile, PhyHook hook)
+    : hook_(hook),
+      mode_since_ms_(0),
+      last_poll_ms_(0),
+      last_link_up_ms_(0),
+      profile_(profile),
+      mode_(PhyMode::kAutoNegotiation),
+      measuring_(false),
+      asleep_(false),
+      waking_(false) {}
+
+void PhyPower::begin(uint32_t now_ms) {
+  mode_since_ms_ = now_ms;
+  set_mode((profile_ == PhyProfile::kAutoNegotiation) ? PhyMode::kAutoNegotiation
+                                                      : PhyMode::k10BaseT,
+           now_ms);
+}
+
+void PhyPower::sleep(uint32_t now_ms) {
+  if (!can_sleep() || asleep_) {
+    return;
+  }
+  asleep_ = true;
+  waking_ = false;
+  set_mode(PhyMode::kPowerDown, now_ms);
+}
+
+void PhyPower::wake(uint32_t now_ms) {
+  if (!asleep_) {
+    return;
+  }
+  asleep_ = false;
+  waking_ = true;
+  set_mode(PhyMode::k10BaseT, now_ms);
+}
+
+bool PhyPower::run(uint32_t now_ms) {
+  if (!measuring_ || (now_ms - last_poll_ms_) < kPollIntervalMs) {
+    return is_ready();
+  }
+  last_poll_ms_ = now_ms;
+
+  uint32_t elapsed = now_ms - mode_since_ms_;
+  if (getPHYCFGR() & PHYCFGR_LNK_ON) {
+    measuring_ = false;
+    waking_ = false;
+    last_link_up_ms_ = static_cast<uint16_t>(elapsed);  // < kLinkTimeoutMs
+    if (hook_) {
+      hook_(PhyEvent::kLinkUp, mode_, elapsed);
+    }
+  } else if (elapsed >= kLinkTimeoutMs) {
+    // Real outage (cable, switch): from here on it is the LinkMonitor's job
+    measuring_ = false;
+    waking_ = false;
+    if (hook_) {
+      hook_(PhyEvent::kLinkTimeout, mode_, elapsed);
+    }
+  }
+  return is_ready();
+}
+
+uint16_t PhyPower::wake_lead_ms() const {
+  if (last_link_up_ms_ == 0) {
+    return kDefaultWakeLeadMs;
+  }
+  return last_link_up_ms_ + kWakeMarginMs;
+}
+
+void PhyPower::set_mode(PhyMode mode, uint32_t now_ms) {
+  if (mode == PhyMode::kPowerDown) {
+    // Needs PHYCFGR.OPMD, set by the 10BASE-T configuration in begin()
+    wizphy_setphypmode(PHY_POWER_DOWN);
+  } else if (mode == PhyMode::k10BaseT) {
+    // Also used to power up: wizphy_setphypmode(PHY_POWER_NORM) would switch
+    // to auto-negotiation
+    wiz_PhyConf conf = {PHY_CONFBY_SW, PHY_MODE_MANUAL, PHY_SPEED_10, PHY_DUPLEX_HALF};
+    wizphy_setphyconf(&conf);
+  }
+
+  uint32_t elapsed = now_ms - mode_since_ms_;
+  mode_ = mode;
+  mode_since_ms_ = now_ms;
+  last_poll_ms_ = now_ms;
+  measuring_ = (mode != PhyMode::kPowerDown);
+  if (hook_) {
+    hook_(PhyEvent::kModeChanged, mode, elapsed);
+  }
+}
+
+}  // namespace Ethernet
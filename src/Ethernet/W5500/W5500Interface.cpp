@@ -57,16 +57,19 @@ void W5500Interface::init() {
 
   this->soft_reset();
 
-  // Socket 0: 4KB TX/RX, remaining sockets: 1KB each
-  uint8_t memsize[2][8] = {{4, 1, 1, 1, 1, 1, 1, 1}, {4, 1, 1, 1, 1, 1, 1, 1}};
+  // Buffer sizes by socket role, see SocketMemoryMap.h
+  SocketMemoryMap memsize = kSocketMemoryMap;
+  static_assert(sizeof(memsize) == 2 * _WIZCHIP_SOCK_NUM_, "CW_INIT_WIZCHIP expects uint8_t[2][8]");
 
-  if (ctlwizchip(CW_INIT_WIZCHIP, reinterpret_cast<void *>(memsize)) == -1) {
+  if (ctlwizchip(CW_INIT_WIZCHIP, reinterpret_cast<void *>(&memsize)) == -1) {
     if (uart_log_) {
-      uart_log_->send_string("WIZCHIP INIT FAILED");
+      uart_log_->send_string(FSTR("WIZCHIP INIT FAILED"));
     }
     return;
   }
 
+  memset(tx_high_, 0, sizeof(tx_high_));
+  memset(rx_high_, 0, sizeof(rx_high_));
   initialized_ = true;
 }
 
@@ -80,7 +83,7 @@ void W5500Interface::hard_reset() {
     cb_hard_reset_();
   } else {
     if (uart_log_) {
-      uart_log_->send_string("No hard reset callback defined");
+      uart_log_->send_string(FSTR("No hard reset callback defined"));
     }
   }
   _delay_ms(100);
@@ -175,4 +178,36 @@ void W5500Interface::get_gateway(GatewayAddress *gateway) const {
   memcpy(gateway->addr, netInfo_.gw, 4);
 }
 
+void W5500Interface::sample_buffers() {
+  for (uint8_t sn = 0; sn < kSocketCount; sn++) {
+    if (kSocketMemoryMap.tx_kb[sn] == 0 && kSocketMemoryMap.rx_kb[sn] == 0) {
+      continue;
+    }
+    SocketBufferUse use = buffer_use(sn);
+    if (use.tx_used > tx_high_[sn]) {
+      tx_high_[sn] = use.tx_used;
+    }
+    if (use.rx_used > rx_high_[sn]) {
+      rx_high_[sn] = use.rx_used;
+    }
+  }
+}
+
+SocketBufferUse W5500Interface::buffer_use(uint8_t socket) const {
+  SocketBufferUse use = {0, 0, 0, 0};
+  if (socket >= kSocketCount) {
+    return use;
+  }
+  if (kSocketMemoryMap.tx_kb[socket] != 0) {
+    use.tx_used = getSn_TxMAX(socket) - getSn_TX_FSR(socket);
+  }
+  if (kSocketMemoryMap.rx_kb[socket] != 0) {
+    use.rx_used = getSn_RX_RSR(socket);
+  }
+  // Also covers a peak between two sample_buffers() calls that is still there
+  use.tx_high = (use.tx_used > tx_high_[socket]) ? use.tx_used : tx_high_[socket];
+  use.rx_high = (use.rx_used > rx_high_[socket]) ? use.rx_used : rx_high_[socket];
+  return use;
+}
+
 }  // namespace Ethernet
@@ -16,6 +16,7 @@
 #endif
 
 #include <string.h>
+#include "System/LogFilter.h"
 #include "System/TimerService.h"
 
 #ifdef __AVR__
@@ -31,58 +32,113 @@ extern "C" {
 namespace MQTT {
 
 MinimalMQTT::MinimalMQTT(serial::UART* uart)
-    : uart_(uart), state_(State::DISCONNECTED), last_activity_(0), last_ping_(0), packet_id_(1) {
+    : uart_(uart),
+      state_(State::DISCONNECTED),
+      framer_(recv_buffer_, kRecvBufferSize),
+      last_puback_latency_ms_(0),
+      queue_count_(0),
+      last_activity_(0),
+      last_ping_(0),
+      ping_pending_(false),
+      tx_unsent_(0),
+      send_in_flight_(false),
+      applied_rtr_ms_(0),
+      applied_rcr_(0),
+      packet_id_(1),
+      session_present_(false) {
   memset(&config_, 0, sizeof(Config));
+  memset(inflight_, 0, sizeof(inflight_));
+  memset(queue_, 0, sizeof(queue_));
+  for (uint8_t i = 0; i < kPriorityCount; i++) {
+    tokens_[i] = token_burst(static_cast<Priority>(i));
+    last_refill_[i] = 0;
+  }
+  memset(&connect_cache_, 0, sizeof(ConnectCache));
   memset(send_buffer_, 0, kSendBufferSize);
   memset(recv_buffer_, 0, kRecvBufferSize);
 
-  // Initialize subscriptions
-  for (uint8_t i = 0; i < kMaxSubscriptions; i++) {
-    subscriptions_[i].active = false;
-    subscriptions_[i].callback = nullptr;
-  }
+  clear_subscriptions();
 }
 
 bool MinimalMQTT::connect(const Config& config) {
-  log("[MQTT] Connecting...\r\n");
+  SB_LOG_INFO(uart_, kMQTT, "[MQTT] Connecting...\r\n");
 
-  // Remove all existing subscriptions on new connect attempt
-  for (uint8_t i = 0; i < kMaxSubscriptions; i++) {
-    subscriptions_[i].active = false;
-    subscriptions_[i].callback = nullptr;
+  // Store config, CONNECT lengths are only recomputed when it changed
+  if (memcmp(&config_, &config, sizeof(Config)) != 0 || connect_cache_.remaining_length == 0) {
+    memcpy(&config_, &config, sizeof(Config));
+    update_connect_cache();
   }
-
-  // Store config
-  memcpy(&config_, &config, sizeof(Config));
   state_ = State::CONNECTING;
+  session_present_ = false;
+
+  // Registered subscriptions are kept, but must be confirmed again
+  for (uint8_t i = 0; i < kMaxSubscriptions; i++) {
+    subscriptions_[i].packet_id = 0;
+    subscriptions_[i].granted = false;
+  }
 
-  // Connect TCP socket to broker
+  // Connect TCP socket to broker, nothing of the old stream may survive
+  framer_.reset();
+  apply_retry_timers();
   if (!socket_connect()) {
-    log("[MQTT] Socket connect failed\r\n");
+    SB_LOG_ERROR(uart_, kMQTT, "[MQTT] Socket connect failed\r\n");
     state_ = State::ERROR;
     return false;
   }
 
   // Send CONNECT packet
   if (!send_connect_packet()) {
-    log("[MQTT] CONNECT failed\r\n");
+    SB_LOG_ERROR(uart_, kMQTT, "[MQTT] CONNECT failed\r\n");
     socket_disconnect();
     state_ = State::ERROR;
     return false;
   }
 
+  // Clean session: broker has no filters for us, so pipeline the SUBSCRIBE
+  // right behind CONNECT instead of paying another round trip after CONNACK.
+  uint8_t pending = active_subscription_mask();
+  if (config_.clean_session && pending != 0) {
+    if (!send_subscribe_packet(pending)) {
+      SB_LOG_ERROR(uart_, kMQTT, "[MQTT] SUBSCRIBE failed\r\n");
+      socket_disconnect();
+      state_ = State::ERROR;
+      return false;
+    }
+    pending = 0;
+  }
+
   // Wait for CONNACK
   if (!wait_for_connack()) {
-    log("[MQTT] CONNACK failed\r\n");
+    SB_LOG_ERROR(uart_, kMQTT, "[MQTT] CONNACK failed\r\n");
     socket_disconnect();
     state_ = State::ERROR;
     return false;
   }
 
-  log("[MQTT] Connected\r\n");
+  SB_LOG_INFO(uart_, kMQTT, "[MQTT] Connected\r\n");
   state_ = State::CONNECTED;
   last_activity_ = System::TimerService::millis();
   last_ping_ = last_activity_;
+  ping_pending_ = false;
+
+  // Persistent session: the broker still holds our filters if it reports a
+  // stored session, otherwise subscribe now.
+  if (pending != 0) {
+    if (session_present_) {
+      SB_LOG_INFO(uart_, kMQTT, "[MQTT] Session resumed\r\n");
+      for (uint8_t i = 0; i < kMaxSubscriptions; i++) {
+        subscriptions_[i].granted = subscriptions_[i].active;
+      }
+    } else if (!send_subscribe_packet(pending)) {
+      SB_LOG_ERROR(uart_, kMQTT, "[MQTT] SUBSCRIBE failed\r\n");
+    }
+  }
+
+  // Announce presence before anything else goes out
+  publish_birth();
+
+  // QoS 1 messages of the previous connection are still unacknowledged
+  retransmit_inflight(true);
 
   return true;
 }
@@ -92,62 +148,81 @@ void MinimalMQTT::disconnect() {
     return;
   }
 
-  // Send DISCONNECT packet
-  send_buffer_[0] = static_cast<uint8_t>(MessageType::DISCONNECT);
-  send_buffer_[1] = 0;  // Remaining length = 0
-  socket_send(send_buffer_, 2);
+  // Send DISCONNECT packet, before the FIN (otherwise the broker sends the will)
+  socket_send(kDisconnectPacket.bytes, kDisconnectPacket.size());
+  drain_send();
 
   socket_disconnect();
   state_ = State::DISCONNECTED;
 
-  // Remove all subscriptions
-  for (uint8_t i = 0; i < kMaxSubscriptions; i++) {
-    subscriptions_[i].active = false;
-    subscriptions_[i].callback = nullptr;
+  SB_LOG_INFO(uart_, kMQTT, "[MQTT] Disconnected\r\n");
+}
+
+void MinimalMQTT::abort() {
+  if (state_ == State::DISCONNECTED) {
+    return;
   }
 
-  log("[MQTT] Disconnected\r\n");
+  // No DISCONNECT / FIN handshake: over a dead link both would only run into timeouts
+  close(kMQTTSocketNumber);
+  state_ = State::DISCONNECTED;
+
+  SB_LOG_WARN(uart_, kMQTT, "[MQTT] Connection dropped\r\n");
 }
 
 bool MinimalMQTT::publish(const char* topic, const uint8_t* payload, uint16_t length) {
-  if (state_ != State::CONNECTED) {
-    return false;
-  }
+  return publish_prepared(prepare_publish(topic, length), payload);
+}
 
-  uint16_t pos = 0;
+bool MinimalMQTT::publish(const Utils::FlashString* topic, const uint8_t* payload,
+                          uint16_t length) {
+  uint16_t topic_len = Utils::flash_strlen(topic);
+  if (topic_len > 0xFF) {
+    topic_len = 0xFF;
+  }
+  return publish_prepared(prepare_publish_header(Utils::progmem_ptr(topic),
+                                                 static_cast<uint8_t>(topic_len), length, true),
+                          payload);
+}
 
-  // Fixed header: PUBLISH + QoS0
-  send_buffer_[pos++] = static_cast<uint8_t>(MessageType::PUBLISH);
+bool MinimalMQTT::publish_string(const char* topic, const char* message) {
+  return publish(topic, reinterpret_cast<const uint8_t*>(message), strlen(message));
+}
 
-  // Calculate remaining length
+PreparedPublish MinimalMQTT::prepare_publish(const char* topic, uint16_t payload_length) {
   uint16_t topic_len = strlen(topic);
-  uint16_t remaining = 2 + topic_len + length;  // topic_len(2) + topic + payload
+  if (topic_len > 0xFF) {
+    topic_len = 0xFF;  // Rejected as too large by publish_prepared()
+  }
+  return prepare_publish_header(topic, static_cast<uint8_t>(topic_len), payload_length);
+}
 
-  // Check buffer size
-  if (remaining + 2 > kSendBufferSize) {
-    log("[MQTT] Publish too large\r\n");
+bool MinimalMQTT::publish_prepared(const PreparedPublish& packet, const uint8_t* payload,
+                                   QoS qos) {
+  if (state_ != State::CONNECTED) {
     return false;
   }
 
-  // Encode remaining length (1-byte for small messages)
-  if (remaining < 128) {
-    send_buffer_[pos++] = remaining & 0x7F;
-  } else {
-    send_buffer_[pos++] = (remaining & 0x7F) | 0x80;
-    send_buffer_[pos++] = (remaining >> 7) & 0x7F;
+  if (qos == QoS::kAtLeastOnce) {
+    return publish_qos1(packet, payload);
   }
 
-  // Topic length
-  send_buffer_[pos++] = (topic_len >> 8) & 0xFF;
-  send_buffer_[pos++] = topic_len & 0xFF;
-
-  // Topic
-  memcpy(&send_buffer_[pos], topic, topic_len);
-  pos += topic_len;
+  // Check buffer size
+  uint16_t total = packet.header_length + packet.topic_length + packet.payload_length;
+  if (total > kSendBufferSize) {
+    SB_LOG_ERROR(uart_, kMQTT, "[MQTT] Publish too large\r\n");
+    return false;
+  }
 
-  // Payload
-  memcpy(&send_buffer_[pos], payload, length);
-  pos += length;
+  // Header and topic length are pre-encoded, only gather the pieces
+  memcpy(send_buffer_, packet.header, packet.header_length);
+  uint16_t pos = packet.header_length;
+  copy_topic(&send_buffer_[pos], packet.topic, packet.topic_length, packet.topic_in_flash);
+  pos += packet.topic_length;
+  if (packet.payload_length > 0) {
+    memcpy(&send_buffer_[pos], payload, packet.payload_length);
+    pos += packet.payload_length;
+  }
 
   // Send
   bool success = socket_send(send_buffer_, pos);
@@ -158,76 +233,367 @@ bool MinimalMQTT::publish(const char* topic, const uint8_t* payload, uint16_t le
   return success;
 }
 
-bool MinimalMQTT::publish_string(const char* topic, const char* message) {
-  return publish(topic, reinterpret_cast<const uint8_t*>(message), strlen(message));
+bool MinimalMQTT::publish_qos1(const PreparedPublish& packet, const uint8_t* payload) {
+  // Packet id (2) on top of the QoS 0 layout
+  uint16_t remaining = 2 + packet.topic_length + 2 + packet.payload_length;
+  if (packet.payload_length > kMaxInflightPayload ||
+      1U + remaining_length_size(remaining) + remaining > kSendBufferSize) {
+    SB_LOG_ERROR(uart_, kMQTT, "[MQTT] Publish too large\r\n");
+    return false;
+  }
+
+  InflightMessage* message = nullptr;
+  for (uint8_t i = 0; i < kMaxInflight; i++) {
+    if (inflight_[i].packet_id == 0) {
+      message = &inflight_[i];
+      break;
+    }
+  }
+  if (message == nullptr) {
+    SB_LOG_WARN(uart_, kMQTT, "[MQTT] In-flight window full\r\n");
+    return false;
+  }
+
+  message->topic = packet.topic;
+  message->topic_length = packet.topic_length;
+  message->topic_in_flash = packet.topic_in_flash;
+  message->payload_length = static_cast<uint8_t>(packet.payload_length);
+  if (packet.payload_length > 0) {
+    memcpy(message->payload, payload, packet.payload_length);
+  }
+  message->packet_id = next_packet_id();
+
+  // Accepted even if the send fails: the retransmit timer (or the next
+  // connect) delivers it
+  send_inflight(*message, false);
+  return true;
 }
 
-bool MinimalMQTT::subscribe(const char* topic, MessageCallback callback) {
-  if (state_ != State::CONNECTED || callback == nullptr) {
+bool MinimalMQTT::send_inflight(InflightMessage& message, bool dup) {
+  uint16_t remaining = 2 + message.topic_length + 2 + message.payload_length;
+
+  uint16_t pos = 0;
+  send_buffer_[pos++] = static_cast<uint8_t>(MessageType::PUBLISH) | kPublishFlagQos1 |
+                        (dup ? kPublishFlagDup : 0);
+  pos += encode_remaining_length(&send_buffer_[pos], remaining);
+  pos += encode_string(&send_buffer_[pos], message.topic, message.topic_length,
+                       message.topic_in_flash);
+  send_buffer_[pos++] = (message.packet_id >> 8) & 0xFF;
+  send_buffer_[pos++] = message.packet_id & 0xFF;
+  memcpy(&send_buffer_[pos], message.payload, message.payload_length);
+  pos += message.payload_length;
+
+  message.sent_at = System::TimerService::millis();
+  bool success = socket_send(send_buffer_, pos);
+  if (success) {
+    last_activity_ = message.sent_at;
+  }
+  return success;
+}
+
+void MinimalMQTT::retransmit_inflight(bool all) {
+  uint32_t now = System::TimerService::millis();
+
+  for (uint8_t i = 0; i < kMaxInflight; i++) {
+    InflightMessage& message = inflight_[i];
+    if (message.packet_id == 0) {
+      continue;
+    }
+    if (all || (now - message.sent_at) >= kPubackTimeoutMs) {
+      SB_LOG_DEBUG(uart_, kMQTT, "[MQTT] Resending QoS 1 publish\r\n");
+      send_inflight(message, true);
+    }
+  }
+}
+
+bool MinimalMQTT::queue_publish(const PreparedPublish& packet, const uint8_t* payload,
+                                Priority priority, QoS qos) {
+  if (packet.payload_length > kMaxQueuedPayload) {
+    SB_LOG_ERROR(uart_, kMQTT, "[MQTT] Publish too large\r\n");
     return false;
   }
 
-  // Find free subscription slot
-  uint8_t slot = kMaxSubscriptions;
-  for (uint8_t i = 0; i < kMaxSubscriptions; i++) {
-    if (!subscriptions_[i].active) {
-      slot = i;
-      break;
+  QueuedMessage* entry = nullptr;
+
+  // A newer state message supersedes a queued one for the same topic
+  if (priority == Priority::kState) {
+    for (uint8_t i = 0; i < queue_count_; i++) {
+      if (queue_[i].priority == Priority::kState && queue_[i].topic == packet.topic) {
+        entry = &queue_[i];
+        break;
+      }
     }
   }
 
-  if (slot >= kMaxSubscriptions) {
-    log("[MQTT] No free subscription slots\r\n");
+  if (entry == nullptr) {
+    if (queue_count_ >= kOutboundQueueSize) {
+      // Make room by dropping the newest message of the lowest lower class
+      uint8_t victim = kOutboundQueueSize;
+      for (uint8_t i = 0; i < queue_count_; i++) {
+        if (queue_[i].priority > priority &&
+            (victim == kOutboundQueueSize || queue_[i].priority >= queue_[victim].priority)) {
+          victim = i;
+        }
+      }
+      if (victim == kOutboundQueueSize) {
+        SB_LOG_WARN(uart_, kMQTT, "[MQTT] Outbound queue full\r\n");
+        return false;
+      }
+      remove_queued(victim);
+    }
+    entry = &queue_[queue_count_++];
+  }
+
+  entry->topic = packet.topic;
+  entry->topic_length = packet.topic_length;
+  entry->topic_in_flash = packet.topic_in_flash;
+  entry->payload_length = static_cast<uint8_t>(packet.payload_length);
+  if (packet.payload_length > 0) {
+    memcpy(entry->payload, payload, packet.payload_length);
+  }
+  entry->priority = priority;
+  entry->qos = qos;
+  return true;
+}
+
+void MinimalMQTT::flush_outbound() {
+  if (queue_count_ == 0) {
+    return;
+  }
+
+  refill_tokens();
+
+  // QoS 0 messages are gathered in send_buffer_ and sent together
+  uint16_t batch = 0;
+  bool tx_full = false;
+
+  for (uint8_t p = 0; p < kPriorityCount && !tx_full; p++) {
+    uint8_t i = 0;
+    while (i < queue_count_ && tokens_[p] > 0) {
+      QueuedMessage& entry = queue_[i];
+      if (static_cast<uint8_t>(entry.priority) != p) {
+        i++;
+        continue;
+      }
+
+      PreparedPublish packet = prepare_publish_header(entry.topic, entry.topic_length,
+                                                      entry.payload_length, entry.topic_in_flash);
+
+      if (entry.qos == QoS::kAtLeastOnce) {
+        // Needs a free window slot, otherwise it waits for the next loop()
+        if (inflight_count() >= kMaxInflight) {
+          i++;
+          continue;
+        }
+        // publish_qos1() builds its packet in send_buffer_ as well
+        if (batch > 0 && !send_batch(batch)) {
+          return;
+        }
+        batch = 0;
+        if (!publish_qos1(packet, entry.payload)) {
+          i++;
+          continue;
+        }
+      } else {
+        uint16_t size = packet.header_length + packet.topic_length + packet.payload_length;
+        if (size > kSendBufferSize) {
+          SB_LOG_ERROR(uart_, kMQTT, "[MQTT] Publish too large\r\n");
+          remove_queued(i);
+          continue;
+        }
+        if (batch + size > kSendBufferSize) {
+          if (!send_batch(batch)) {
+            return;
+          }
+          batch = 0;
+        }
+        // TCP window full: the rest stays queued for the next loop()
+        if (socket_tx_space() < batch + size) {
+          tx_full = true;
+          break;
+        }
+        memcpy(&send_buffer_[batch], packet.header, packet.header_length);
+        batch += packet.header_length;
+        copy_topic(&send_buffer_[batch], packet.topic, packet.topic_length,
+                   packet.topic_in_flash);
+        batch += packet.topic_length;
+        memcpy(&send_buffer_[batch], entry.payload, packet.payload_length);
+        batch += packet.payload_length;
+      }
+
+      tokens_[p]--;
+      remove_queued(i);
+    }
+  }
+
+  if (batch > 0) {
+    send_batch(batch);
+  }
+}
+
+bool MinimalMQTT::send_batch(uint16_t length) {
+  if (!socket_send(send_buffer_, length)) {
+    SB_LOG_WARN(uart_, kMQTT, "[MQTT] Queue flush failed\r\n");
+    state_ = State::ERROR;
     return false;
   }
+  last_activity_ = System::TimerService::millis();
+  return true;
+}
 
-  uint16_t pos = 0;
+void MinimalMQTT::refill_tokens() {
+  uint32_t now = System::TimerService::millis();
 
-  // Fixed header: SUBSCRIBE
-  send_buffer_[pos++] = static_cast<uint8_t>(MessageType::SUBSCRIBE);
+  for (uint8_t p = 0; p < kPriorityCount; p++) {
+    Priority priority = static_cast<Priority>(p);
+    uint8_t burst = token_burst(priority);
+    uint16_t refill_ms = token_refill_ms(priority);
 
-  // Calculate remaining length
-  uint16_t topic_len = strlen(topic);
-  uint16_t remaining = 2 + 2 + topic_len + 1;  // packet_id(2) + topic_len(2) + topic + qos(1)
+    if (tokens_[p] >= burst) {
+      last_refill_[p] = now;  // Full bucket does not accumulate time
+      continue;
+    }
 
-  // Encode remaining length
-  if (remaining < 128) {
-    send_buffer_[pos++] = remaining & 0x7F;
-  } else {
-    send_buffer_[pos++] = (remaining & 0x7F) | 0x80;
-    send_buffer_[pos++] = (remaining >> 7) & 0x7F;
+    uint32_t gained = (now - last_refill_[p]) / refill_ms;
+    if (gained == 0) {
+      continue;
+    }
+    last_refill_[p] += gained * refill_ms;
+    tokens_[p] = (tokens_[p] + gained >= burst) ? burst : static_cast<uint8_t>(tokens_[p] + gained);
+  }
+}
+
+void MinimalMQTT::remove_queued(uint8_t index) {
+  // Shift to keep FIFO order within each class
+  for (uint8_t i = index; i + 1 < queue_count_; i++) {
+    queue_[i] = queue_[i + 1];
   }
+  queue_count_--;
+}
 
-  // Packet ID
-  send_buffer_[pos++] = (packet_id_ >> 8) & 0xFF;
-  send_buffer_[pos++] = packet_id_ & 0xFF;
-  packet_id_++;
+uint8_t MinimalMQTT::inflight_count() const {
+  uint8_t count = 0;
+  for (uint8_t i = 0; i < kMaxInflight; i++) {
+    if (inflight_[i].packet_id != 0) {
+      count++;
+    }
+  }
+  return count;
+}
 
-  // Topic length
-  send_buffer_[pos++] = (topic_len >> 8) & 0xFF;
-  send_buffer_[pos++] = topic_len & 0xFF;
+uint32_t MinimalMQTT::next_ping_in_ms() const {
+  uint32_t ping_interval = (config_.keepalive * 1000UL * 3) / 4;
+  uint32_t since_ping = System::TimerService::millis() - last_ping_;
+  return (since_ping < ping_interval) ? ping_interval - since_ping : 0;
+}
 
-  // Topic
-  memcpy(&send_buffer_[pos], topic, topic_len);
-  pos += topic_len;
+bool MinimalMQTT::is_idle() const {
+  if (state_ != State::CONNECTED || queue_count_ != 0 || ping_pending_ || send_pending() ||
+      inflight_count() != 0) {
+    return false;
+  }
+  // Sent but not yet ACKed segments still need the link
+  return getSn_TX_FSR(kMQTTSocketNumber) == getSn_TxMAX(kMQTTSocketNumber);
+}
 
-  // QoS = 0
-  send_buffer_[pos++] = 0;
+uint16_t MinimalMQTT::next_packet_id() {
+  uint16_t id = packet_id_;
+  if (++packet_id_ == 0) {
+    packet_id_ = 1;
+  }
+  return id;
+}
 
-  // Send
-  bool success = socket_send(send_buffer_, pos);
-  if (success) {
-    // Store subscription
-    strncpy(subscriptions_[slot].topic, topic, kMaxTopicLength - 1);
-    subscriptions_[slot].topic[kMaxTopicLength - 1] = '\0';
-    subscriptions_[slot].callback = callback;
-    subscriptions_[slot].active = true;
+bool MinimalMQTT::subscribe(const char* topic, MessageCallback callback) {
+  return add_subscription(topic, false, callback);
+}
 
-    last_activity_ = System::TimerService::millis();
-    log("[MQTT] Subscribed\r\n");
+bool MinimalMQTT::subscribe(const Utils::FlashString* topic, MessageCallback callback) {
+  return add_subscription(Utils::progmem_ptr(topic), true, callback);
+}
+
+bool MinimalMQTT::add_subscription(const char* topic, bool in_flash, MessageCallback callback) {
+  if (topic == nullptr || callback == nullptr) {
+    return false;
   }
 
-  return success;
+  // Filters from flash are parsed and compared from a stack copy
+  char flash_copy[kMaxTopicLength + 1];
+  const char* text = topic;
+  if (in_flash) {
+    uint16_t length = Utils::flash_strlen(Utils::as_flash(topic));
+    if (length > kMaxTopicLength) {
+      SB_LOG_ERROR(uart_, kMQTT, "[MQTT] Invalid topic filter\r\n");
+      return false;
+    }
+    Utils::flash_copy(flash_copy, Utils::as_flash(topic), length + 1);
+    text = flash_copy;
+  }
+
+  TopicFilter filter;
+  if (!filter.compile(text)) {
+    SB_LOG_ERROR(uart_, kMQTT, "[MQTT] Invalid topic filter\r\n");
+    return false;
+  }
+
+  // Reuse the slot of an already registered topic, otherwise take a free one
+  uint8_t slot = kMaxSubscriptions;
+  for (uint8_t i = 0; i < kMaxSubscriptions; i++) {
+    const Subscription& sub = subscriptions_[i];
+    bool same = sub.active && (sub.topic_in_flash
+                                   ? Utils::flash_compare(text, Utils::as_flash(sub.topic)) == 0
+                                   : strcmp(sub.topic, text) == 0);
+    if (same) {
+      slot = i;
+      break;
+    }
+    if (!subscriptions_[i].active && slot == kMaxSubscriptions) {
+      slot = i;
+    }
+  }
+
+  if (slot >= kMaxSubscriptions) {
+    SB_LOG_ERROR(uart_, kMQTT, "[MQTT] No free subscription slots\r\n");
+    return false;
+  }
+
+  Subscription& sub = subscriptions_[slot];
+  bool known = sub.active;
+  sub.callback = callback;
+  if (!known) {
+    sub.topic = topic;
+    sub.topic_in_flash = in_flash;
+    sub.filter = filter;
+    sub.packet_id = 0;
+    sub.granted = false;
+    sub.active = true;
+  }
+
+  // Not connected yet: connect() sends it together with the other filters
+  if (state_ != State::CONNECTED || known) {
+    return true;
+  }
+
+  return send_subscribe_packet(static_cast<uint8_t>(1U << slot));
+}
+
+void MinimalMQTT::clear_subscriptions() {
+  for (uint8_t i = 0; i < kMaxSubscriptions; i++) {
+    subscriptions_[i].active = false;
+    subscriptions_[i].granted = false;
+    subscriptions_[i].packet_id = 0;
+    subscriptions_[i].callback = nullptr;
+    subscriptions_[i].topic = nullptr;
+  }
+}
+
+bool MinimalMQTT::subscriptions_granted() const {
+  for (uint8_t i = 0; i < kMaxSubscriptions; i++) {
+    if (subscriptions_[i].active && !subscriptions_[i].granted) {
+      return false;
+    }
+  }
+  return true;
 }
 
 void MinimalMQTT::loop() {
@@ -237,13 +603,28 @@ void MinimalMQTT::loop() {
 
   // Check socket status
   if (!socket_is_connected()) {
-    log("[MQTT] Socket disconnected\r\n");
+    SB_LOG_WARN(uart_, kMQTT, "[MQTT] Socket disconnected\r\n");
     state_ = State::ERROR;
     return;
   }
 
+  // Next SEND for packets written while the previous one was in flight
+  service_send();
+
   // Process incoming messages
-  process_incoming_packet();
+  process_incoming_packets();
+  if (state_ != State::CONNECTED) {
+    return;
+  }
+
+  // Send queued publishes (PUBACKs above may have freed in-flight slots)
+  flush_outbound();
+  if (state_ != State::CONNECTED) {
+    return;
+  }
+
+  // QoS 1: resend publishes whose PUBACK is overdue
+  retransmit_inflight(false);
 
   // Keepalive: send PINGREQ if idle
   uint32_t now = System::TimerService::millis();
@@ -258,9 +639,12 @@ void MinimalMQTT::loop() {
 
   // Timeout if no activity for keepalive * 1.5
   if (idle_time > (config_.keepalive * 1500UL)) {
-    log("[MQTT] Keepalive timeout\r\n");
+    SB_LOG_WARN(uart_, kMQTT, "[MQTT] Keepalive timeout\r\n");
     state_ = State::ERROR;
+    return;
   }
+
+  service_send();
 }
 
 // ==================== Private Methods ====================
@@ -270,22 +654,9 @@ bool MinimalMQTT::socket_connect() {
   close(kMQTTSocketNumber);
 
 #ifdef __AVR__
-  // W5500 link negotiation can lag behind reset/init; wait up to ~5s.
-  uint8_t phy = 0;
-  bool link_up = false;
-  for (uint8_t i = 0; i < 50; i++) {
-    phy = getPHYCFGR();
-    if (phy & PHYCFGR_LNK_ON) {
-      link_up = true;
-      break;
-    }
-    wdt_reset();
-    for (uint16_t j = 0; j < 1000; j++) {
-      asm volatile("nop");
-    }
-  }
-  if (!link_up) {
-    log("[MQTT] No link\r\n");
+  // No link: fail now, the caller retries later
+  if ((getPHYCFGR() & PHYCFGR_LNK_ON) == 0) {
+    SB_LOG_DEBUG(uart_, kMQTT, "[MQTT] No link\r\n");
     return false;
   }
 #endif
@@ -295,33 +666,53 @@ bool MinimalMQTT::socket_connect() {
   if (result != kMQTTSocketNumber) {
     return false;
   }
+  tx_unsent_ = 0;
+  send_in_flight_ = false;
+  setSn_IR(kMQTTSocketNumber, Sn_IR_SENDOK);  // Stale from the previous connection
 
-  // Connect to broker
+  // Connect to broker. Non-blocking: the blocking connect() spins without
+  // wdt_reset() until the W5500 gives up (~30 s with its default timers)
+  uint32_t start = System::TimerService::millis();
+  uint8_t io_mode = SOCK_IO_NONBLOCK;
+  ctlsocket(kMQTTSocketNumber, CS_SET_IOMODE, &io_mode);
   result = ::connect(kMQTTSocketNumber, config_.broker_ip, config_.broker_port);
-  if (result != SOCK_OK) {
+  io_mode = SOCK_IO_BLOCK;
+  ctlsocket(kMQTTSocketNumber, CS_SET_IOMODE, &io_mode);
+  if (result != SOCK_OK && result != SOCK_BUSY) {
     close(kMQTTSocketNumber);
     return false;
   }
 
-  // Wait for connection (timeout 5s)
-  // wdt_reset() prevents WDT from firing during this blocking wait
-  for (uint8_t i = 0; i < 50; i++) {
+  // The W5500 retransmits the SYN itself and closes the socket when its
+  // timers run out; the loop bound is only a safety net behind that.
+  // wdt_reset() prevents WDT from firing during this wait
+  uint32_t timeout = segment_timeout_ms() + retry_time_ms();
+  if (timeout > kConnackTimeoutMs) {
+    timeout = kConnackTimeoutMs;
+  }
+  do {
 #ifdef __AVR__
     wdt_reset();
 #endif
     uint8_t status = getSn_SR(kMQTTSocketNumber);
     if (status == SOCK_ESTABLISHED) {
+      // Handshake RTT. Karn: a SYN that was retransmitted gives no sample,
+      // the RTO is backed off instead so it can grow past the real RTT
+      uint32_t elapsed = System::TimerService::millis() - start;
+      if (elapsed < retry_time_ms()) {
+        rtt_.add_sample(static_cast<uint16_t>(elapsed));
+      } else {
+        rtt_.backoff();
+      }
+      apply_retry_timers();
       return true;
     }
     if (status == SOCK_CLOSED || status == SOCK_CLOSE_WAIT) {
       return false;
     }
-    // Wait 100ms
-    for (uint16_t j = 0; j < 1000; j++) {
-      asm volatile("nop");
-    }
-  }
+  } while ((System::TimerService::millis() - start) < timeout);
 
+  close(kMQTTSocketNumber);
   return false;
 }
 
@@ -330,10 +721,54 @@ void MinimalMQTT::socket_disconnect() {
   close(kMQTTSocketNumber);
 }
 
+// Not through send() of the ioLibrary: that waits for SENDOK of the previous
+// SEND (SOCK_BUSY in non-blocking mode), so back to back packets either block
+// on the RTT or need a copy in SRAM until the W5500 takes them. Here the data
+// goes straight into the TX buffer, which is the queue; service_send() issues
+// the next SEND once SENDOK arrived.
 bool MinimalMQTT::socket_send(const uint8_t* data, uint16_t length) {
-  // W5500 send() requires non-const pointer (but doesn't modify data)
-  int32_t sent = send(kMQTTSocketNumber, const_cast<uint8_t*>(data), length);
-  return (sent == length);
+  // Whole packets only. A partial write would have to be completed before any
+  // other packet; the caller keeps the packet (queue, in-flight window) instead
+  if (getSn_SR(kMQTTSocketNumber) != SOCK_ESTABLISHED || socket_tx_space() < length) {
+    return false;
+  }
+  // wiz_send_data() takes a non-const pointer but does not modify the data
+  wiz_send_data(kMQTTSocketNumber, const_cast<uint8_t*>(data), length);
+  tx_unsent_ += length;
+  service_send();
+  return true;
+}
+
+uint16_t MinimalMQTT::socket_tx_space() const {
+  uint16_t free_size = getSn_TX_FSR(kMQTTSocketNumber);
+  return (free_size > tx_unsent_) ? free_size - tx_unsent_ : 0;
+}
+
+void MinimalMQTT::service_send() {
+  if (send_in_flight_) {
+    // Sn_IR_TIMEOUT closes the socket, loop() sees that in the status
+    if ((getSn_IR(kMQTTSocketNumber) & Sn_IR_SENDOK) == 0) {
+      return;
+    }
+    setSn_IR(kMQTTSocketNumber, Sn_IR_SENDOK);
+    send_in_flight_ = false;
+  }
+  if (tx_unsent_ == 0) {
+    return;
+  }
+  setSn_CR(kMQTTSocketNumber, Sn_CR_SEND);
+  while (getSn_CR(kMQTTSocketNumber)) {
+  }
+  tx_unsent_ = 0;
+  send_in_flight_ = true;
+}
+
+void MinimalMQTT::drain_send() {
+  uint32_t start = System::TimerService::millis();
+  while (send_pending() && getSn_SR(kMQTTSocketNumber) == SOCK_ESTABLISHED &&
+         (System::TimerService::millis() - start) < retry_time_ms()) {
+    service_send();
+  }
 }
 
 int16_t MinimalMQTT::socket_recv(uint8_t* buffer, uint16_t max_length) {
@@ -353,190 +788,442 @@ bool MinimalMQTT::socket_is_connected() {
   return (status == SOCK_ESTABLISHED);
 }
 
-bool MinimalMQTT::send_connect_packet() {
-  uint16_t pos = 0;
-
-  // Fixed header
-  send_buffer_[pos++] = static_cast<uint8_t>(MessageType::CONNECT);
+void MinimalMQTT::update_connect_cache() {
+  connect_cache_.client_id_length = strnlen(config_.client_id, kMaxClientIdLength);
+  connect_cache_.username_length =
+      config_.use_auth ? strnlen(config_.username, kMaxUsernameLength) : 0;
+  connect_cache_.password_length =
+      config_.use_auth ? strnlen(config_.password, kMaxPasswordLength) : 0;
+
+  bool will = (config_.will_topic != nullptr && config_.will_payload != nullptr);
+  connect_cache_.will_topic_length = will ? strnlen(config_.will_topic, kMaxTopicLength) : 0;
+  connect_cache_.will_payload_length = 0;
+  if (will) {
+    connect_cache_.will_payload_length =
+        config_.presence_in_flash
+            ? Utils::flash_strnlen(Utils::as_flash(config_.will_payload), kMaxWillPayloadLength)
+            : strnlen(config_.will_payload, kMaxWillPayloadLength);
+  }
 
-  // Calculate remaining length
-  uint16_t remaining = 10;  // Variable header
-  remaining += 2 + strlen(config_.client_id);
+  uint16_t remaining = kConnectVariableHeaderLength + 2 + connect_cache_.client_id_length;
+  if (will) {
+    remaining += 2 + connect_cache_.will_topic_length;
+    remaining += 2 + connect_cache_.will_payload_length;
+  }
   if (config_.use_auth) {
-    remaining += 2 + strlen(config_.username);
-    remaining += 2 + strlen(config_.password);
+    remaining += 2 + connect_cache_.username_length;
+    remaining += 2 + connect_cache_.password_length;
   }
+  connect_cache_.remaining_length = remaining;
+}
 
-  // Remaining length (assume < 128 bytes)
-  send_buffer_[pos++] = remaining & 0x7F;
+bool MinimalMQTT::send_connect_packet() {
+  bool will = (connect_cache_.will_topic_length > 0);
+  uint16_t pos = 0;
 
-  // Protocol name: "MQTT"
-  send_buffer_[pos++] = 0;
-  send_buffer_[pos++] = 4;
-  send_buffer_[pos++] = 'M';
-  send_buffer_[pos++] = 'Q';
-  send_buffer_[pos++] = 'T';
-  send_buffer_[pos++] = 'T';
+  // Fixed header
+  send_buffer_[pos++] = static_cast<uint8_t>(MessageType::CONNECT);
+  pos += encode_remaining_length(&send_buffer_[pos], connect_cache_.remaining_length);
 
-  // Protocol level: 4 (MQTT 3.1.1)
-  send_buffer_[pos++] = kMQTTProtocolLevel;
+  // Protocol name "MQTT" + level 4 (MQTT 3.1.1), constant
+  memcpy(&send_buffer_[pos], kConnectProtocolHeader.bytes, kConnectProtocolHeader.size());
+  pos += kConnectProtocolHeader.size();
 
   // Connect flags
-  uint8_t flags = 0x02;  // Clean session
-  if (config_.use_auth) {
-    flags |= 0x80;  // Username flag
-    flags |= 0x40;  // Password flag
-  }
-  send_buffer_[pos++] = flags;
+  send_buffer_[pos++] = connect_flags(config_.clean_session, config_.use_auth, will,
+                                      config_.will_qos, config_.will_retain);
 
   // Keepalive
   send_buffer_[pos++] = (config_.keepalive >> 8) & 0xFF;
   send_buffer_[pos++] = config_.keepalive & 0xFF;
 
   // Client ID
-  uint16_t id_len = strlen(config_.client_id);
-  send_buffer_[pos++] = (id_len >> 8) & 0xFF;
-  send_buffer_[pos++] = id_len & 0xFF;
-  memcpy(&send_buffer_[pos], config_.client_id, id_len);
-  pos += id_len;
+  pos += encode_string(&send_buffer_[pos], config_.client_id, connect_cache_.client_id_length);
+
+  // Last Will
+  if (will) {
+    if (!append_string(pos, config_.will_topic, connect_cache_.will_topic_length) ||
+        !append_string(pos, config_.will_payload, connect_cache_.will_payload_length,
+                       config_.presence_in_flash)) {
+      return false;
+    }
+  }
 
   // Username & Password
   if (config_.use_auth) {
-    uint16_t user_len = strlen(config_.username);
-    send_buffer_[pos++] = (user_len >> 8) & 0xFF;
-    send_buffer_[pos++] = user_len & 0xFF;
-    memcpy(&send_buffer_[pos], config_.username, user_len);
-    pos += user_len;
-
-    uint16_t pass_len = strlen(config_.password);
-    send_buffer_[pos++] = (pass_len >> 8) & 0xFF;
-    send_buffer_[pos++] = pass_len & 0xFF;
-    memcpy(&send_buffer_[pos], config_.password, pass_len);
-    pos += pass_len;
+    if (!append_string(pos, config_.username, connect_cache_.username_length) ||
+        !append_string(pos, config_.password, connect_cache_.password_length)) {
+      return false;
+    }
   }
 
   return socket_send(send_buffer_, pos);
 }
 
+bool MinimalMQTT::append_string(uint16_t& pos, const char* str, uint8_t length, bool in_flash) {
+  // CONNECT with will and auth can exceed send_buffer_: send what we have first
+  if (pos + 2U + length > kSendBufferSize) {
+    if (!socket_send(send_buffer_, pos)) {
+      return false;
+    }
+    pos = 0;
+  }
+  pos += encode_string(&send_buffer_[pos], str, length, in_flash);
+  return true;
+}
+
+void MinimalMQTT::publish_birth() {
+  if (connect_cache_.will_topic_length == 0 || config_.birth_payload == nullptr) {
+    return;
+  }
+
+  // Same topic and retain flag as the will, so the retained "online" replaces
+  // the retained will payload
+  uint8_t payload[kMaxWillPayloadLength];
+  uint16_t length;
+  if (config_.presence_in_flash) {
+    const Utils::FlashString* birth = Utils::as_flash(config_.birth_payload);
+    length = Utils::flash_strnlen(birth, kMaxWillPayloadLength);
+    Utils::flash_copy(payload, birth, length);
+  } else {
+    length = strnlen(config_.birth_payload, kMaxWillPayloadLength);
+    memcpy(payload, config_.birth_payload, length);
+  }
+  PreparedPublish packet =
+      prepare_publish_header(config_.will_topic, connect_cache_.will_topic_length, length);
+  if (config_.will_retain) {
+    packet.header[0] |= kPublishFlagRetain;
+  }
+
+  if (!publish_prepared(packet, payload)) {
+    SB_LOG_WARN(uart_, kMQTT, "[MQTT] Birth message failed\r\n");
+  }
+}
+
+bool MinimalMQTT::send_subscribe_packet(uint8_t slot_mask) {
+  // Remaining length: packet_id(2) + per topic: topic_len(2) + topic + qos(1)
+  uint16_t remaining = 2;
+  for (uint8_t i = 0; i < kMaxSubscriptions; i++) {
+    if (slot_mask & (1U << i)) {
+      const Subscription& sub = subscriptions_[i];
+      remaining += 2 + string_length(sub.topic, sub.topic_in_flash) + 1;
+    }
+  }
+
+  // Fixed header takes at most 3 bytes for this buffer size
+  if (remaining + 3 > kSendBufferSize) {
+    SB_LOG_ERROR(uart_, kMQTT, "[MQTT] Subscribe too large\r\n");
+    return false;
+  }
+
+  uint16_t pos = 0;
+  send_buffer_[pos++] = static_cast<uint8_t>(MessageType::SUBSCRIBE);
+  pos += encode_remaining_length(&send_buffer_[pos], remaining);
+
+  // One packet id covers every topic filter in this packet
+  uint16_t id = next_packet_id();
+  send_buffer_[pos++] = (id >> 8) & 0xFF;
+  send_buffer_[pos++] = id & 0xFF;
+
+  for (uint8_t i = 0; i < kMaxSubscriptions; i++) {
+    if (slot_mask & (1U << i)) {
+      const Subscription& sub = subscriptions_[i];
+      pos += encode_string(&send_buffer_[pos], sub.topic,
+                           static_cast<uint8_t>(string_length(sub.topic, sub.topic_in_flash)),
+                           sub.topic_in_flash);
+      send_buffer_[pos++] = 0;  // QoS 0
+    }
+  }
+
+  if (!socket_send(send_buffer_, pos)) {
+    return false;
+  }
+
+  // SUBACK return codes arrive in slot order, matched by packet id
+  for (uint8_t i = 0; i < kMaxSubscriptions; i++) {
+    if (slot_mask & (1U << i)) {
+      subscriptions_[i].packet_id = id;
+      subscriptions_[i].granted = false;
+    }
+  }
+
+  last_activity_ = System::TimerService::millis();
+  SB_LOG_DEBUG(uart_, kMQTT, "[MQTT] Subscribe sent\r\n");
+  return true;
+}
+
 bool MinimalMQTT::wait_for_connack() {
-  // Wait up to 5 seconds for CONNACK
   uint32_t start = System::TimerService::millis();
+  Packet packet;
 
-  while ((System::TimerService::millis() - start) < 5000) {
-    int16_t len = socket_recv(recv_buffer_, kRecvBufferSize);
-    if (len >= 4) {
-      // Check for CONNACK
-      if (recv_buffer_[0] == static_cast<uint8_t>(MessageType::CONNACK) && recv_buffer_[1] == 2) {
-        // Check return code
-        uint8_t return_code = recv_buffer_[3];
-        if (return_code == 0) {
-          return true;  // Connection accepted
-        }
-        log("[MQTT] CONNACK refused\r\n");
-        return false;
+  // A lost CONNECT is retransmitted by the W5500 within segment_timeout_ms();
+  // one more RTO leaves the broker time to process it
+  uint32_t timeout = segment_timeout_ms() + retry_time_ms();
+  if (timeout > kConnackTimeoutMs) {
+    timeout = kConnackTimeoutMs;
+  }
+
+  // wdt_reset() prevents WDT from firing during this wait
+  while ((System::TimerService::millis() - start) < timeout) {
+#ifdef __AVR__
+    wdt_reset();
+#endif
+    service_send();  // SUBSCRIBE pipelined behind CONNECT
+    int16_t len = socket_recv(framer_.free_space(), framer_.free_length());
+    if (len <= 0) {
+      // Retransmissions exhausted or reset by the broker
+      if (getSn_SR(kMQTTSocketNumber) != SOCK_ESTABLISHED) {
+        break;
+      }
+      continue;
+    }
+    framer_.commit(static_cast<uint16_t>(len));
+
+    if (!framer_.next(packet)) {
+      if (framer_.error()) {
+        break;
       }
+      continue;
+    }
+
+    if (packet.header != static_cast<uint8_t>(MessageType::CONNACK) || packet.length != 2) {
+      SB_LOG_ERROR(uart_, kMQTT, "[MQTT] Expected CONNACK\r\n");
+      return false;
+    }
+
+    // Check return code
+    if (packet.body[1] != 0) {
+      SB_LOG_ERROR(uart_, kMQTT, "[MQTT] CONNACK refused\r\n");
+      return false;
     }
+
+    // Session present is only meaningful for a persistent session
+    session_present_ = !config_.clean_session && (packet.body[0] & kConnackSessionPresent);
+
+    // Packets sharing the segment (SUBACK of the pipelined SUBSCRIBE, retained
+    // PUBLISHes) stay in the framer and are handled by loop()
+    return true;  // Connection accepted
   }
 
-  log("[MQTT] CONNACK timeout\r\n");
+  SB_LOG_ERROR(uart_, kMQTT, "[MQTT] CONNACK timeout\r\n");
   return false;
 }
 
-void MinimalMQTT::send_pingreq() {
-  send_buffer_[0] = static_cast<uint8_t>(MessageType::PINGREQ);
-  send_buffer_[1] = 0;
+uint16_t MinimalMQTT::retry_time_ms() const {
+  uint16_t rtr = (config_.retry_time_ms != 0) ? config_.retry_time_ms : rtt_.rto_ms();
+  return (rtr > RttEstimator::kMaxRtrMs) ? RttEstimator::kMaxRtrMs : rtr;
+}
 
-  if (socket_send(send_buffer_, 2)) {
-    last_ping_ = System::TimerService::millis();
-  }
+uint32_t MinimalMQTT::segment_timeout_ms() const {
+  uint8_t rcr = (config_.retry_count != 0) ? config_.retry_count : kDefaultRetryCount;
+  return RttEstimator::timeout_ms(retry_time_ms(), rcr);
 }
 
-void MinimalMQTT::process_incoming_packet() {
-  int16_t len = socket_recv(recv_buffer_, kRecvBufferSize);
-  if (len <= 0) {
+void MinimalMQTT::apply_retry_timers() {
+  uint16_t rtr = retry_time_ms();
+  uint8_t rcr = (config_.retry_count != 0) ? config_.retry_count : kDefaultRetryCount;
+  if (rtr == applied_rtr_ms_ && rcr == applied_rcr_) {
     return;
   }
+#ifdef __AVR__
+  wiz_NetTimeout timeout = {rcr, static_cast<uint16_t>(rtr * 10)};  // RTR in 100 us
+  wizchip_settimeout(&timeout);
+#endif
+  applied_rtr_ms_ = rtr;
+  applied_rcr_ = rcr;
+}
 
-  last_activity_ = System::TimerService::millis();
+void MinimalMQTT::send_pingreq() {
+  if (socket_send(kPingreqPacket.bytes, kPingreqPacket.size())) {
+    last_ping_ = System::TimerService::millis();
+    ping_pending_ = true;
+  }
+}
 
-  uint8_t header_byte = recv_buffer_[0];
-  uint8_t msg_type = header_byte & 0xF0;
+void MinimalMQTT::process_incoming_packets() {
+  uint32_t start = System::TimerService::millis();
+  Packet packet;
+
+  do {
+    // Handle everything already buffered before reading more
+    while (framer_.next(packet)) {
+      handle_packet(packet);
+      if (state_ != State::CONNECTED) {
+        return;  // Callback disconnected
+      }
+      if ((System::TimerService::millis() - start) >= kRecvBudgetMs) {
+        return;  // Rest follows on the next loop()
+      }
+    }
 
-  // WICHTIG: Holt die QoS-Bits aus dem Header-Byte für die spätere Abfrage (qos > 0)
-  uint8_t qos = (header_byte & 0x06) >> 1;
+    if (framer_.error()) {
+      SB_LOG_ERROR(uart_, kMQTT, "[MQTT] Malformed packet\r\n");
+      state_ = State::ERROR;
+      return;
+    }
 
-  // Handle PINGRESP
-  if (msg_type == static_cast<uint8_t>(MessageType::PINGRESP)) {
-    return;
-  }
+    int16_t len = socket_recv(framer_.free_space(), framer_.free_length());
+    if (len <= 0) {
+      return;
+    }
+    framer_.commit(static_cast<uint16_t>(len));
+    last_activity_ = System::TimerService::millis();
+  } while ((System::TimerService::millis() - start) < kRecvBudgetMs);
+}
+
+void MinimalMQTT::handle_packet(const Packet& packet) {
+  uint8_t msg_type = packet.header & 0xF0;
 
-  // Handle PUBLISH
   if (msg_type == static_cast<uint8_t>(MessageType::PUBLISH)) {
-    uint16_t pos = 1;
-    uint32_t multiplier = 1;
-    uint32_t rem_len = 0;
-    uint8_t encoded_byte;
-
-    // Remaining Length decodieren (Variable Byte Integer)
-    do {
-      if (pos >= static_cast<uint16_t>(len))
-        return;  // Out-of-Bounds Schutz
-      encoded_byte = recv_buffer_[pos++];
-      rem_len += (encoded_byte & 127) * multiplier;
-      multiplier *= 128;
-    } while ((encoded_byte & 128) != 0);
-
-    if (pos + 2 > static_cast<uint16_t>(len))
-      return;  // Out-of-Bounds Schutz
+    handle_publish(packet);
+  } else if (msg_type == static_cast<uint8_t>(MessageType::PUBACK)) {
+    handle_puback(packet);
+  } else if (msg_type == static_cast<uint8_t>(MessageType::SUBACK)) {
+    handle_suback(packet);
+  } else if (msg_type == static_cast<uint8_t>(MessageType::PINGRESP) && ping_pending_) {
+    // last_activity_ was updated on receive; the round trip refines the RTO
+    ping_pending_ = false;
+    uint32_t rtt = System::TimerService::millis() - last_ping_;
+    if (rtt < retry_time_ms()) {
+      rtt_.add_sample(static_cast<uint16_t>(rtt));
+    } else {
+      rtt_.backoff();
+    }
+    apply_retry_timers();
+  }
+}
 
-    // Topic Length decodieren
-    uint16_t topic_len = (recv_buffer_[pos] << 8) | recv_buffer_[pos + 1];
-    pos += 2;
+void MinimalMQTT::handle_publish(const Packet& packet) {
+  // WICHTIG: Holt die QoS-Bits aus dem Header-Byte für die spätere Abfrage (qos > 0)
+  uint8_t qos = (packet.header & 0x06) >> 1;
+  uint16_t pos = 0;
+
+  if (packet.length < 2)
+    return;  // Out-of-Bounds Schutz
+
+  // Topic Length decodieren
+  uint16_t topic_len = (packet.body[0] << 8) | packet.body[1];
+  pos += 2;
+
+  if (pos + topic_len > packet.length)
+    return;  // Out-of-Bounds Schutz
 
-    if (pos + topic_len > static_cast<uint16_t>(len))
+  const char* topic = reinterpret_cast<const char*>(&packet.body[pos]);
+
+  // Hash the topic levels once, every filter then compares 16-bit values
+  TopicHashes topic_hashes;
+  topic_hashes.compute(topic, topic_len);
+
+  // Null-terminierte Kopie für den Callback
+  char topic_str[kMaxTopicLength];
+  uint16_t copy_len = (topic_len < kMaxTopicLength - 1) ? topic_len : (kMaxTopicLength - 1);
+  memcpy(topic_str, topic, copy_len);
+  topic_str[copy_len] = '\0';
+  pos += topic_len;
+
+  // Packet ID überspringen (falls QoS > 0)
+  if (qos > 0) {
+    if (pos + 2 > packet.length)
       return;  // Out-of-Bounds Schutz
+    pos += 2;
+  }
+
+  // Payload bestimmen
+  const uint8_t* payload = &packet.body[pos];
+  uint16_t payload_len = packet.length - pos;
+
+  // First matching filter gets the message (overlapping filters must not
+  // trigger the same gong twice). The hashes only reject, a hit is confirmed
+  // against the filter string
+  for (uint8_t i = 0; i < kMaxSubscriptions; i++) {
+    const Subscription& sub = subscriptions_[i];
+    if (sub.active && sub.callback != nullptr && sub.filter.matches(topic_hashes) &&
+        sub.filter.confirm(sub.topic, sub.topic_in_flash, topic, topic_len)) {
+      sub.callback(topic_str, payload, payload_len);
+      break;
+    }
+  }
+}
+
+void MinimalMQTT::handle_puback(const Packet& packet) {
+  if (packet.length < 2) {
+    return;
+  }
+
+  uint16_t id = (packet.body[0] << 8) | packet.body[1];
+  for (uint8_t i = 0; i < kMaxInflight; i++) {
+    if (inflight_[i].packet_id == id) {
+      uint32_t latency = System::TimerService::millis() - inflight_[i].sent_at;
+      last_puback_latency_ms_ = (latency > 0xFFFF) ? 0xFFFF : static_cast<uint16_t>(latency);
+      inflight_[i].packet_id = 0;
+      return;
+    }
+  }
+}
+
+void MinimalMQTT::handle_suback(const Packet& packet) {
+  // Packet id(2) + at least one return code
+  if (packet.length < 3) {
+    return;
+  }
 
-    // ======================================================================
-    // DEINE ÄNDERUNG: Sicher in lokalen Buffer extrahieren
-    // ======================================================================
-    char topic_str[kMaxTopicLength];
-    uint16_t copy_len = (topic_len < kMaxTopicLength - 1) ? topic_len : (kMaxTopicLength - 1);
-    memcpy(topic_str, &recv_buffer_[pos], copy_len);
-    topic_str[copy_len] = '\0';
-    pos += topic_len;
-
-    // ======================================================================
-    // DEINE ÄNDERUNG: Packet ID überspringen (falls QoS > 0)
-    // ======================================================================
-    if (qos > 0) {
-      if (pos + 2 > static_cast<uint16_t>(len))
-        return;  // Out-of-Bounds Schutz
-      pos += 2;
-    }
-
-    // Payload bestimmen
-    const uint8_t* payload = &recv_buffer_[pos];
-    uint16_t payload_len = static_cast<uint16_t>(len) - pos;
-
-    // ======================================================================
-    // DEINE ÄNDERUNG: Callbacks aufrufen
-    // ======================================================================
-    for (uint8_t i = 0; i < kMaxSubscriptions; i++) {
-      if (subscriptions_[i].active && strcmp(subscriptions_[i].topic, topic_str) == 0 &&
-          subscriptions_[i].callback != nullptr) {
-        subscriptions_[i].callback(topic_str, payload, payload_len);
+  uint16_t id = (packet.body[0] << 8) | packet.body[1];
+  const uint8_t* codes = &packet.body[2];
+  uint16_t code_count = packet.length - 2;
+  uint8_t next = 0;
+
+  for (uint8_t i = 0; i < kMaxSubscriptions && next < code_count; i++) {
+    if (subscriptions_[i].active && subscriptions_[i].packet_id == id) {
+      subscriptions_[i].packet_id = 0;
+      subscriptions_[i].granted = (codes[next++] != kSubackFailure);
+      if (!subscriptions_[i].granted) {
+        SB_LOG_WARN(uart_, kMQTT, "[MQTT] Subscribe rejected\r\n");
       }
     }
+  }
+}
 
-    // Die fehlerhafte Zeile "recv_buffer_[...] = original_byte;" wurde gelöscht,
-    // da sie dank deiner "topic_str"-Änderung nicht mehr gebraucht wird!
+uint8_t MinimalMQTT::active_subscription_mask() const {
+  uint8_t mask = 0;
+  for (uint8_t i = 0; i < kMaxSubscriptions; i++) {
+    if (subscriptions_[i].active) {
+      mask |= static_cast<uint8_t>(1U << i);
+    }
   }
+  return mask;
+}
+
+uint16_t MinimalMQTT::encode_string(uint8_t* buffer, const char* str, uint8_t length,
+                                    bool in_flash) {
+  buffer[0] = 0;
+  buffer[1] = length;
+  copy_topic(&buffer[2], str, length, in_flash);
+  return length + 2;
+}
+
+uint16_t MinimalMQTT::string_length(const char* str, bool in_flash) {
+  return in_flash ? Utils::flash_strlen(Utils::as_flash(str)) : strlen(str);
 }
 
-void MinimalMQTT::log(const char* message) {
-  if (uart_ != nullptr) {
-    uart_->send_string(message);
+void MinimalMQTT::copy_topic(uint8_t* dest, const char* topic, uint8_t length, bool in_flash) {
+  if (in_flash) {
+    Utils::flash_copy(dest, Utils::as_flash(topic), length);
+  } else {
+    memcpy(dest, topic, length);
   }
 }
 
+uint16_t MinimalMQTT::encode_remaining_length(uint8_t* buffer, uint16_t length) {
+  uint16_t pos = 0;
+  do {
+    uint8_t encoded = length & 0x7F;
+    length >>= 7;
+    if (length > 0) {
+      encoded |= 0x80;
+    }
+    buffer[pos++] = encoded;
+  } while (length > 0);
+  return pos;
+}
+
 }  // namespace MQTT
@@ -0,0 +1,145 @@
+#include "MQTT/MinimalMQTTSN.h"
+
+#include <string.h>
+#include "System/LogFilter.h"
+#include "System/TimerService.h"
+
+#ifdef __AVR__
+// W5500 socket API
+extern "C" {
+#include "W5500/w5500.h"
+#include "socket.h"
+}
+#else
+// Test build - mock socket API (provided by test fixture)
+#endif
+
+namespace MQTT {
+
+MinimalMQTTSN::MinimalMQTTSN(serial::UART* uart)
+    : uart_(uart),
+      state_(SN::State::CLOSED),
+      gateway_port_(0),
+      keepalive_(0),
+      last_activity_(0),
+      last_ping_(0) {
+  memset(gateway_ip_, 0, sizeof(gateway_ip_));
+  memset(buffer_, 0, sizeof(buffer_));
+}
+
+bool MinimalMQTTSN::begin(const uint8_t* gateway_ip, uint16_t gateway_port) {
+  memcpy(gateway_ip_, gateway_ip, sizeof(gateway_ip_));
+  gateway_port_ = gateway_port;
+
+  close(kSocketNumber);
+  if (socket(kSocketNumber, Sn_MR_UDP, kLocalPort, 0) != kSocketNumber) {
+    SB_LOG_ERROR(uart_, kMQTT, "[MQTT-SN] Socket open failed\r\n");
+    state_ = SN::State::CLOSED;
+    return false;
+  }
+
+  state_ = SN::State::READY;
+  return true;
+}
+
+void MinimalMQTTSN::end() {
+  if (state_ == SN::State::CONNECTED) {
+    buffer_[0] = 2;
+    buffer_[1] = static_cast<uint8_t>(SN::MessageType::DISCONNECT);
+    send_datagram(2);
+  }
+  close(kSocketNumber);
+  state_ = SN::State::CLOSED;
+}
+
+bool MinimalMQTTSN::connect(const char* client_id, uint16_t keepalive) {
+  if (state_ == SN::State::CLOSED) {
+    return false;
+  }
+
+  uint8_t length = SN::build_connect(buffer_, SN::kBufferSize, client_id, keepalive);
+  if (length == 0 || !send_datagram(length)) {
+    SB_LOG_ERROR(uart_, kMQTT, "[MQTT-SN] CONNECT failed\r\n");
+    return false;
+  }
+
+  keepalive_ = keepalive;
+  last_activity_ = System::TimerService::millis();
+  last_ping_ = last_activity_;
+  state_ = SN::State::CONNECTING;
+  return true;
+}
+
+bool MinimalMQTTSN::publish(uint16_t topic_id, const uint8_t* payload, uint8_t length,
+                            SN::QoS qos) {
+  // QoS -1 only needs the socket, QoS 0 an accepted CONNECT
+  if (state_ == SN::State::CLOSED ||
+      (qos != SN::QoS::kMinusOne && state_ != SN::State::CONNECTED)) {
+    return false;
+  }
+
+  uint8_t total = SN::build_publish(buffer_, SN::kBufferSize, topic_id, qos, payload, length);
+  if (total == 0) {
+    SB_LOG_ERROR(uart_, kMQTT, "[MQTT-SN] Publish too large\r\n");
+    return false;
+  }
+  return send_datagram(total);
+}
+
+void MinimalMQTTSN::loop() {
+  if (state_ == SN::State::CLOSED) {
+    return;
+  }
+
+  // One datagram per call, replies are rare (CONNACK, PINGRESP)
+  if (getSn_RX_RSR(kSocketNumber) > 0) {
+    uint8_t from_ip[4];
+    uint16_t from_port;
+    int32_t len = recvfrom(kSocketNumber, buffer_, SN::kBufferSize, from_ip, &from_port);
+
+    if (len >= 2 && memcmp(from_ip, gateway_ip_, 4) == 0) {
+      last_activity_ = System::TimerService::millis();
+      uint8_t msg_type = buffer_[1];
+
+      if (msg_type == static_cast<uint8_t>(SN::MessageType::CONNACK) && len >= 3) {
+        if (buffer_[2] == 0) {
+          SB_LOG_INFO(uart_, kMQTT, "[MQTT-SN] Connected\r\n");
+          state_ = SN::State::CONNECTED;
+        } else {
+          SB_LOG_ERROR(uart_, kMQTT, "[MQTT-SN] CONNACK refused\r\n");
+          state_ = SN::State::READY;
+        }
+      } else if (msg_type == static_cast<uint8_t>(SN::MessageType::DISCONNECT)) {
+        state_ = SN::State::READY;
+      }
+      // PINGRESP: last_activity_ already updated
+    }
+  }
+
+  if (state_ != SN::State::CONNECTED && state_ != SN::State::CONNECTING) {
+    return;
+  }
+
+  uint32_t now = System::TimerService::millis();
+
+  // Send ping at 75% of keepalive interval
+  if ((now - last_ping_) > (keepalive_ * 1000UL * 3) / 4) {
+    buffer_[0] = 2;
+    buffer_[1] = static_cast<uint8_t>(SN::MessageType::PINGREQ);
+    send_datagram(2);
+    last_ping_ = now;
+  }
+
+  // Gateway gone: fall back to connectionless QoS -1
+  if ((now - last_activity_) > (keepalive_ * 1500UL)) {
+    SB_LOG_WARN(uart_, kMQTT, "[MQTT-SN] Gateway timeout\r\n");
+    state_ = SN::State::READY;
+  }
+}
+
+bool MinimalMQTTSN::send_datagram(uint8_t length) {
+  int32_t sent = sendto(kSocketNumber, buffer_, length, gateway_ip_, gateway_port_);
+  return (sent == length);
+}
+
+}  // namespace MQTT
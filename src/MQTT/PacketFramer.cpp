@@ -0,0 +1,131 @@
+#include "MQTT/PacketFramer.h"
+
+#include <string.h>
+
+namespace MQTT {
+
+// Remaining length is encoded in at most 4 bytes
+constexpr uint8_t kMaxRemainingLengthBytes = 4;
+
+PacketFramer::PacketFramer(uint8_t* buffer, uint16_t capacity)
+    : buffer_(buffer), capacity_(capacity), dropped_(0) {
+  reset();
+}
+
+void PacketFramer::reset() {
+  fill_ = 0;
+  consumed_ = 0;
+  remaining_ = 0;
+  length_bytes_ = 0;
+  state_ = State::kHeader;
+}
+
+uint8_t* PacketFramer::free_space() {
+  drop(consumed_);
+  consumed_ = 0;
+  return &buffer_[fill_];
+}
+
+uint16_t PacketFramer::free_length() {
+  drop(consumed_);
+  consumed_ = 0;
+  return capacity_ - fill_;
+}
+
+void PacketFramer::commit(uint16_t length) {
+  fill_ += length;
+  if (fill_ > capacity_) {
+    fill_ = capacity_;
+  }
+}
+
+bool PacketFramer::next(Packet& packet) {
+  // Release the packet delivered by the previous call
+  drop(consumed_);
+  consumed_ = 0;
+
+  while (true) {
+    switch (state_) {
+      case State::kHeader:
+        if (fill_ == 0) {
+          return false;
+        }
+        remaining_ = 0;
+        length_bytes_ = 0;
+        state_ = State::kLength;
+        break;
+
+      case State::kLength: {
+        uint8_t pos = 1 + length_bytes_;
+        if (fill_ <= pos) {
+          return false;
+        }
+        uint8_t encoded = buffer_[pos];
+        remaining_ |= static_cast<uint32_t>(encoded & 0x7F) << (7 * length_bytes_);
+        length_bytes_++;
+
+        if (encoded & 0x80) {
+          if (length_bytes_ >= kMaxRemainingLengthBytes) {
+            fill_ = 0;
+            state_ = State::kError;
+            return false;
+          }
+          break;
+        }
+
+        if (1U + length_bytes_ + remaining_ > capacity_) {
+          // Too large for the buffer: skip header and body as they arrive
+          drop(1 + length_bytes_);
+          if (dropped_ < 0xFF) {
+            dropped_++;
+          }
+          state_ = State::kDiscard;
+        } else {
+          state_ = State::kBody;
+        }
+        break;
+      }
+
+      case State::kBody: {
+        uint16_t total = 1 + length_bytes_ + static_cast<uint16_t>(remaining_);
+        if (fill_ < total) {
+          return false;
+        }
+        packet.header = buffer_[0];
+        packet.body = &buffer_[1 + length_bytes_];
+        packet.length = static_cast<uint16_t>(remaining_);
+        consumed_ = total;
+        state_ = State::kHeader;
+        return true;
+      }
+
+      case State::kDiscard: {
+        uint16_t skip = (remaining_ < fill_) ? static_cast<uint16_t>(remaining_) : fill_;
+        drop(skip);
+        remaining_ -= skip;
+        if (remaining_ > 0) {
+          return false;
+        }
+        state_ = State::kHeader;
+        break;
+      }
+
+      case State::kError:
+        return false;
+    }
+  }
+}
+
+void PacketFramer::drop(uint16_t length) {
+  if (length == 0) {
+    return;
+  }
+  if (length >= fill_) {
+    fill_ = 0;
+    return;
+  }
+  memmove(buffer_, &buffer_[length], fill_ - length);
+  fill_ -= length;
+}
+
+}  // namespace MQTT
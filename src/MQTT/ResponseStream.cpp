@@ -0,0 +1,55 @@
+#include "MQTT/ResponseStream.h"
+
+#include <string.h>
+#include "MQTT/MinimalMQTT.h"
+
+namespace MQTT {
+
+ResponseStream::ResponseStream(MinimalMQTT& client, const char* topic, const char* correlation_id,
+                               uint8_t correlation_length)
+    : client_(&client), topic_(topic), prefix_length_(0), length_(0), ok_(true) {
+  prefix_length_ =
+      (correlation_length > kMaxCorrelationLength) ? kMaxCorrelationLength : correlation_length;
+  memcpy(chunk_, correlation_id, prefix_length_);
+}
+
+void ResponseStream::send(const uint8_t byte) {
+  chunk_[prefix_length_ + 1 + length_++] = byte;
+  if (length_ == kChunkLength) {
+    flush(':');
+  }
+}
+
+void ResponseStream::send_bytes(const uint8_t* const bytes, const uint16_t length) {
+  for (uint16_t i = 0; i < length; i++) {
+    send(bytes[i]);
+  }
+}
+
+void ResponseStream::send_string(const char* string) {
+  while (*string != '\0') {
+    send(static_cast<uint8_t>(*string++));
+  }
+}
+
+bool ResponseStream::finish() {
+  if (length_ > 0) {
+    flush(':');
+  }
+  flush('.');
+  return ok_;
+}
+
+bool ResponseStream::flush(char separator) {
+  chunk_[prefix_length_] = static_cast<uint8_t>(separator);
+  uint16_t total = prefix_length_ + 1 + length_;
+  length_ = 0;
+
+  // Once a chunk is lost the rest is dropped too, the requester sees no end marker
+  if (ok_ && !client_->publish(topic_, chunk_, total)) {
+    ok_ = false;
+  }
+  return ok_;
+}
+
+}  // namespace MQTT
@@ -0,0 +1,51 @@
+#include "MQTT/RttEstimator.h"
+
+namespace MQTT {
+
+void RttEstimator::add_sample(uint16_t rtt_ms) {
+  backoff_rto_ms_ = 0;
+  if (!has_sample_) {
+    // First sample: SRTT = R, RTTVAR = R / 2
+    srtt_x8_ = static_cast<uint32_t>(rtt_ms) << 3;
+    rttvar_x4_ = static_cast<uint32_t>(rtt_ms) << 1;
+    has_sample_ = true;
+    return;
+  }
+
+  // RTTVAR += (|SRTT - R| - RTTVAR) / 4, SRTT += (R - SRTT) / 8
+  uint32_t srtt = srtt_x8_ >> 3;
+  uint32_t error = (rtt_ms > srtt) ? rtt_ms - srtt : srtt - rtt_ms;
+  rttvar_x4_ = rttvar_x4_ - (rttvar_x4_ >> 2) + error;
+  srtt_x8_ = srtt_x8_ - srtt + rtt_ms;
+}
+
+void RttEstimator::backoff() {
+  uint16_t rto = rto_ms();
+  backoff_rto_ms_ = (rto > kMaxRtoMs / 2) ? kMaxRtoMs : static_cast<uint16_t>(rto * 2);
+}
+
+uint16_t RttEstimator::rto_ms() const {
+  if (backoff_rto_ms_ != 0) {
+    return backoff_rto_ms_;
+  }
+  if (!has_sample_) {
+    return kInitialRtoMs;
+  }
+  uint32_t rto = (srtt_x8_ >> 3) + rttvar_x4_;
+  if (rto < kMinRtoMs) {
+    return kMinRtoMs;
+  }
+  return (rto > kMaxRtoMs) ? kMaxRtoMs : static_cast<uint16_t>(rto);
+}
+
+uint32_t RttEstimator::timeout_ms(uint16_t retry_time_ms, uint8_t retry_count) {
+  uint32_t total = 0;
+  uint32_t rtr = (retry_time_ms > kMaxRtrMs) ? kMaxRtrMs : retry_time_ms;
+  for (uint16_t i = 0; i <= retry_count; i++) {
+    total += rtr;
+    rtr = (rtr * 2 > kMaxRtrMs) ? kMaxRtrMs : rtr * 2;
+  }
+  return total;
+}
+
+}  // namespace MQTT
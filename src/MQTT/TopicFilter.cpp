@@ -0,0 +1,139 @@
+#include "MQTT/TopicFilter.h"
+
+#include "Utils/FlashString.h"
+
+namespace MQTT {
+
+uint16_t topic_level_hash(const char* level, uint16_t length) {
+  uint32_t hash = 2166136261UL;
+  for (uint16_t i = 0; i < length; i++) {
+    hash ^= static_cast<uint8_t>(level[i]);
+    hash *= 16777619UL;
+  }
+  return static_cast<uint16_t>((hash >> 16) ^ hash);
+}
+
+void TopicHashes::compute(const char* topic, uint16_t length) {
+  levels = 0;
+  system = (length > 0 && topic[0] == '$');
+
+  uint16_t start = 0;
+  for (uint16_t i = 0; i <= length; i++) {
+    if (i == length || topic[i] == '/') {
+      if (levels < kMaxTopicLevels) {
+        level_hash[levels] = topic_level_hash(&topic[start], i - start);
+      }
+      if (levels < 0xFF) {
+        levels++;
+      }
+      start = i + 1;
+    }
+  }
+}
+
+bool TopicFilter::compile(const char* filter) {
+  levels = 0;
+  single_level_mask = 0;
+  multi_level = false;
+
+  if (filter == nullptr || filter[0] == '\0') {
+    return false;
+  }
+
+  uint16_t start = 0;
+  for (uint16_t i = 0;; i++) {
+    char c = filter[i];
+    if (c != '/' && c != '\0') {
+      continue;
+    }
+
+    uint16_t length = i - start;
+    const char* level = &filter[start];
+
+    if (length == 1 && level[0] == '#') {
+      // '#' must be the last level
+      if (c != '\0') {
+        return false;
+      }
+      multi_level = true;
+      return true;
+    }
+
+    if (levels >= kMaxTopicLevels) {
+      return false;
+    }
+
+    if (length == 1 && level[0] == '+') {
+      single_level_mask |= static_cast<uint8_t>(1U << levels);
+      level_hash[levels] = 0;
+    } else {
+      // Wildcards are only valid as a complete level
+      for (uint16_t j = 0; j < length; j++) {
+        if (level[j] == '+' || level[j] == '#') {
+          return false;
+        }
+      }
+      level_hash[levels] = topic_level_hash(level, length);
+    }
+    levels++;
+
+    if (c == '\0') {
+      return true;
+    }
+    start = i + 1;
+  }
+}
+
+bool TopicFilter::matches(const TopicHashes& topic) const {
+  // "a/#" also matches "a" (the parent level), exact filters need equal depth
+  if (multi_level ? (topic.levels < levels) : (topic.levels != levels)) {
+    return false;
+  }
+
+  // $SYS-style topics are not matched by a filter starting with a wildcard
+  if (topic.system && (levels == 0 || (single_level_mask & 0x01))) {
+    return false;
+  }
+
+  for (uint8_t i = 0; i < levels; i++) {
+    if (!(single_level_mask & (1U << i)) && level_hash[i] != topic.level_hash[i]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool TopicFilter::confirm(const char* filter, bool filter_in_flash, const char* topic,
+                          uint16_t length) const {
+  // matches() already checked the depth, only the literal levels are left
+  const Utils::FlashString* flash_filter = Utils::as_flash(filter);
+  uint16_t f = 0;
+  uint16_t t = 0;
+  for (uint8_t i = 0; i < levels; i++) {
+    if (single_level_mask & (1U << i)) {
+      f++;  // '+'
+      while (t < length && topic[t] != '/') {
+        t++;
+      }
+    } else {
+      for (;; f++, t++) {
+        char c = filter_in_flash ? Utils::flash_char(flash_filter, f) : filter[f];
+        if (c == '/' || c == '\0') {
+          break;
+        }
+        if (t >= length || topic[t] != c) {
+          return false;
+        }
+      }
+      if (t < length && topic[t] != '/') {
+        return false;
+      }
+    }
+    // Both stand on the '/' (or the end) behind level i
+    f++;
+    t++;
+  }
+  return true;
+}
+
+}  // namespace MQTT
@@ -0,0 +1,461 @@
+#include "Network/DHCPClient.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#include <avr/eeprom.h>
+
+#include "Network/DatagramReader.h"
+#include "System/LogFilter.h"
+#include "System/TimerService.h"
+
+extern "C" {
+#include "W5500/w5500.h"
+#include "socket.h"
+}
+
+namespace SmartBell {
+
+namespace {
+
+constexpr uint16_t kClientPort = 68;
+constexpr uint16_t kServerPort = 67;
+
+// BOOTP header up to the magic cookie, options follow
+constexpr uint16_t kOptionsOffset = 240;
+constexpr uint16_t kMinMessageLength = 300;  // BOOTP minimum, some relays drop shorter
+constexpr uint8_t kCookie[4] = {0x63, 0x82, 0x53, 0x63};
+
+// Message types (option 53)
+constexpr uint8_t kDiscover = 1;
+constexpr uint8_t kOffer = 2;
+constexpr uint8_t kRequest = 3;
+constexpr uint8_t kAck = 5;
+constexpr uint8_t kNak = 6;
+
+// Options
+constexpr uint8_t kOptPad = 0;
+constexpr uint8_t kOptSubnet = 1;
+constexpr uint8_t kOptRouter = 3;
+constexpr uint8_t kOptDns = 6;
+constexpr uint8_t kOptRequestedIp = 50;
+constexpr uint8_t kOptLeaseTime = 51;
+constexpr uint8_t kOptMessageType = 53;
+constexpr uint8_t kOptServerId = 54;
+constexpr uint8_t kOptParamList = 55;
+constexpr uint8_t kOptEnd = 255;
+
+// Leases are timed with millis(), so cap them well below the 49 day wrap
+constexpr uint32_t kMaxLeaseS = 1000000UL;
+
+// Lease cache behind the boot id (544)
+constexpr uint16_t kEepromAddr = 560;
+constexpr uint32_t kCacheMagic = 0x44484350;  // "DHCP"
+
+struct LeaseCache {
+  uint32_t magic;
+  uint8_t mac[6];
+  uint8_t ip[4];
+  uint8_t subnet[4];
+  uint8_t gateway[4];
+  uint8_t dns[4];
+  uint8_t server[4];
+};
+
+const uint8_t kBroadcast[4] = {255, 255, 255, 255};
+
+void* eeprom_ptr(size_t offset) {
+  return reinterpret_cast<void*>(static_cast<uintptr_t>(kEepromAddr + offset));
+}
+
+bool is_zero(const uint8_t* ip) { return (ip[0] | ip[1] | ip[2] | ip[3]) == 0; }
+
+// Appends to the socket TX buffer, nothing is kept in SRAM
+void write(const uint8_t* data, uint16_t length) {
+  wiz_send_data(DHCPClient::kDHCPSocket, const_cast<uint8_t*>(data), length);
+}
+
+void write_zeros(uint16_t length) {
+  uint8_t zeros[DatagramReader::kChunkSize] = {};
+  while (length > 0) {
+    uint16_t n = (length < sizeof(zeros)) ? length : sizeof(zeros);
+    write(zeros, n);
+    length -= n;
+  }
+}
+
+uint32_t load_be32(const uint8_t* p) {
+  return (static_cast<uint32_t>(p[0]) << 24) | (static_cast<uint32_t>(p[1]) << 16) |
+         (static_cast<uint32_t>(p[2]) << 8) | p[3];
+}
+
+}  // namespace
+
+DHCPClient::DHCPClient(Ethernet::W5500Interface* w5500, serial::Interface* uart)
+    : w5500_(w5500),
+      uart_(uart),
+      mac_(nullptr),
+      xid_(0),
+      last_send_ms_(0),
+      lease_start_ms_(0),
+      state_(State::kStopped),
+      attempts_(0),
+      has_ip_(false),
+      pending_status_(DHCPStatus::kRunning) {
+  memset(&config_, 0, sizeof(config_));
+  memset(offered_ip_, 0, sizeof(offered_ip_));
+  memset(server_, 0, sizeof(server_));
+}
+
+void DHCPClient::init(const uint8_t* mac) {
+  mac_ = mac;
+  xid_ = (static_cast<uint32_t>(mac[3]) << 24) | (static_cast<uint32_t>(mac[4]) << 16) |
+         (static_cast<uint32_t>(mac[5]) << 8) | (System::TimerService::millis() & 0xFF);
+
+  close(kDHCPSocket);
+  socket(kDHCPSocket, Sn_MR_UDP, kClientPort, 0);
+
+  has_ip_ = false;
+  attempts_ = 0;
+  if (load_cache()) {
+    SB_LOG_INFO(uart_, kNET, "[DHCP] Requesting cached lease\r\n");
+    state_ = State::kInitReboot;
+    send_request();
+  } else {
+    restart();
+  }
+}
+
+void DHCPClient::stop() {
+  close(kDHCPSocket);
+  state_ = State::kStopped;
+}
+
+DHCPStatus DHCPClient::run(bool rx_ready) {
+  if (state_ == State::kStopped) {
+    return DHCPStatus::kStopped;
+  }
+
+  // A foreign broadcast reply (other xid / chaddr) must not hide ours behind it
+  Reply reply;
+  while (rx_ready && getSn_RX_RSR(kDHCPSocket) > 0) {
+    if (receive_reply(reply)) {
+      handle_reply(reply);
+    }
+  }
+
+  uint32_t now = System::TimerService::millis();
+  bool retry_due = (now - last_send_ms_) >= kRetryMs;
+
+  switch (state_) {
+    case State::kInitReboot:
+      if (retry_due) {
+        if (++attempts_ >= kRebootAttempts) {
+          SB_LOG_WARN(uart_, kNET, "[DHCP] No answer for cached lease\r\n");
+          restart();
+        } else {
+          send_request();
+        }
+      }
+      break;
+
+    case State::kSelecting:
+      if (retry_due) {
+        send_discover();
+      }
+      break;
+
+    case State::kRequesting:
+      if (retry_due) {
+        // Offer may be gone, start over instead of requesting forever
+        restart();
+      }
+      break;
+
+    case State::kBound:
+      if (lease_elapsed_s() >= config_.lease_time / 2) {
+        state_ = State::kRenewing;
+        send_request();
+      }
+      break;
+
+    case State::kRenewing:
+    case State::kRebinding:
+      if (lease_elapsed_s() >= config_.lease_time) {
+        SB_LOG_WARN(uart_, kNET, "[DHCP] Lease expired\r\n");
+        has_ip_ = false;
+        restart();
+        return DHCPStatus::kFailed;
+      }
+      if (state_ == State::kRenewing && lease_elapsed_s() >= config_.lease_time / 8 * 7) {
+        state_ = State::kRebinding;
+        send_request();
+      } else if ((now - last_send_ms_) >= kRenewRetryMs) {
+        send_request();
+      }
+      break;
+
+    case State::kStopped:
+      break;
+  }
+
+  if (pending_status_ != DHCPStatus::kRunning) {
+    DHCPStatus status = pending_status_;
+    pending_status_ = DHCPStatus::kRunning;
+    return status;
+  }
+  return has_ip_ ? DHCPStatus::kIPLeased : DHCPStatus::kRunning;
+}
+
+void DHCPClient::restart() {
+  state_ = State::kSelecting;
+  attempts_ = 0;
+  xid_++;
+  send_discover();
+}
+
+void DHCPClient::send_discover() { send_message(kDiscover); }
+
+void DHCPClient::send_request() { send_message(kRequest); }
+
+void DHCPClient::send_message(uint8_t type) {
+  // Renewing: unicast to the server, our address in ciaddr, no option 50/54
+  bool renewing = (state_ == State::kRenewing);
+  bool rebinding = (state_ == State::kRebinding);
+  const uint8_t* destination = renewing ? server_ : kBroadcast;
+
+  setSn_IR(kDHCPSocket, Sn_IR_SENDOK | Sn_IR_TIMEOUT);
+
+  // op, htype, hlen, hops, xid, secs, flags (broadcast reply, we have no IP yet)
+  uint8_t header[12] = {1, 1, 6, 0};
+  header[4] = (xid_ >> 24) & 0xFF;
+  header[5] = (xid_ >> 16) & 0xFF;
+  header[6] = (xid_ >> 8) & 0xFF;
+  header[7] = xid_ & 0xFF;
+  header[10] = (renewing || rebinding) ? 0x00 : 0x80;
+  write(header, sizeof(header));
+
+  // ciaddr, yiaddr, siaddr, giaddr
+  if (renewing || rebinding) {
+    write(config_.ip, 4);
+  } else {
+    write_zeros(4);
+  }
+  write_zeros(12);
+
+  // chaddr (16), sname (64), file (128), magic cookie
+  write(mac_, 6);
+  write_zeros(10 + 64 + 128);
+  write(kCookie, sizeof(kCookie));
+
+  uint8_t options[24];
+  uint8_t n = 0;
+  options[n++] = kOptMessageType;
+  options[n++] = 1;
+  options[n++] = type;
+  if (type == kRequest && !renewing && !rebinding) {
+    const uint8_t* requested = (state_ == State::kInitReboot) ? config_.ip : offered_ip_;
+    options[n++] = kOptRequestedIp;
+    options[n++] = 4;
+    memcpy(&options[n], requested, 4);
+    n += 4;
+    if (state_ == State::kRequesting) {
+      options[n++] = kOptServerId;
+      options[n++] = 4;
+      memcpy(&options[n], server_, 4);
+      n += 4;
+    }
+  }
+  options[n++] = kOptParamList;
+  options[n++] = 3;
+  options[n++] = kOptSubnet;
+  options[n++] = kOptRouter;
+  options[n++] = kOptDns;
+  options[n++] = kOptEnd;
+  write(options, n);
+  if (kOptionsOffset + n < kMinMessageLength) {
+    write_zeros(kMinMessageLength - kOptionsOffset - n);
+  }
+
+  setSn_DIPR(kDHCPSocket, const_cast<uint8_t*>(destination));
+  setSn_DPORT(kDHCPSocket, kServerPort);
+  setSn_CR(kDHCPSocket, Sn_CR_SEND);
+  while (getSn_CR(kDHCPSocket)) {
+  }
+
+  last_send_ms_ = System::TimerService::millis();
+}
+
+bool DHCPClient::receive_reply(Reply& reply) {
+  // Consumes exactly one datagram, valid or not (finish() drops the rest)
+  // W5500 UDP header: source ip(4), source port(2), length(2)
+  uint8_t head[8];
+  wiz_recv_data(kDHCPSocket, head, sizeof(head));
+  DatagramReader reader(kDHCPSocket, (static_cast<uint16_t>(head[6]) << 8) | head[7]);
+
+  memset(&reply, 0, sizeof(reply));
+  uint8_t fixed[12];
+  uint8_t chaddr[6];
+  uint8_t cookie[4];
+  bool valid = reader.read(fixed, sizeof(fixed)) && fixed[0] == 2 &&
+               load_be32(&fixed[4]) == xid_;
+  if (valid) {
+    reader.skip(4);  // ciaddr
+    valid = reader.read(reply.ip, 4);
+    reader.skip(8);  // siaddr, giaddr
+    valid = valid && reader.read(chaddr, sizeof(chaddr)) && memcmp(chaddr, mac_, 6) == 0;
+    reader.skip(10 + 64 + 128);
+    valid = valid && reader.read(cookie, sizeof(cookie)) &&
+            memcmp(cookie, kCookie, sizeof(cookie)) == 0;
+  }
+
+  // Options: only the first 4 bytes of list options (router, dns) are used
+  uint8_t code = kOptPad;
+  while (valid && reader.read(code) && code != kOptEnd) {
+    if (code == kOptPad) {
+      continue;
+    }
+    uint8_t length;
+    if (!reader.read(length)) {
+      break;
+    }
+    uint8_t value[4] = {};
+    uint8_t used = (length < sizeof(value)) ? length : sizeof(value);
+    reader.read(value, used);
+    reader.skip(length - used);
+
+    switch (code) {
+      case kOptMessageType:
+        reply.type = value[0];
+        break;
+      case kOptSubnet:
+        memcpy(reply.subnet, value, 4);
+        break;
+      case kOptRouter:
+        memcpy(reply.gateway, value, 4);
+        break;
+      case kOptDns:
+        memcpy(reply.dns, value, 4);
+        break;
+      case kOptServerId:
+        memcpy(reply.server, value, 4);
+        break;
+      case kOptLeaseTime:
+        reply.lease_time = load_be32(value);
+        break;
+      default:
+        break;
+    }
+  }
+
+  reader.finish();
+  return valid;
+}
+
+void DHCPClient::handle_reply(const Reply& reply) {
+  if (reply.type == kOffer && state_ == State::kSelecting) {
+    memcpy(offered_ip_, reply.ip, 4);
+    memcpy(server_, reply.server, 4);
+    state_ = State::kRequesting;
+    send_request();
+    return;
+  }
+
+  if (reply.type == kNak) {
+    SB_LOG_WARN(uart_, kNET, "[DHCP] NAK\r\n");
+    invalidate_cache();
+    if (has_ip_) {
+      pending_status_ = DHCPStatus::kFailed;
+    }
+    has_ip_ = false;
+    restart();
+    return;
+  }
+
+  if (reply.type != kAck || state_ == State::kSelecting || state_ == State::kBound) {
+    return;
+  }
+
+  bool changed = memcmp(config_.ip, reply.ip, 4) != 0;
+  memcpy(config_.ip, reply.ip, 4);
+  memcpy(config_.subnet, reply.subnet, 4);
+  memcpy(config_.gateway, reply.gateway, 4);
+  memcpy(config_.dns, reply.dns, 4);
+  if (!is_zero(reply.server)) {
+    memcpy(server_, reply.server, 4);
+  }
+  config_.lease_time = (reply.lease_time == 0 || reply.lease_time > kMaxLeaseS)
+                           ? kMaxLeaseS
+                           : reply.lease_time;
+  lease_start_ms_ = System::TimerService::millis();
+
+  if (!has_ip_) {
+    pending_status_ = DHCPStatus::kIPAssign;
+  } else if (changed) {
+    pending_status_ = DHCPStatus::kIPChanged;
+  }
+  has_ip_ = true;
+  state_ = State::kBound;
+  save_cache();
+  SB_LOG_INFO(uart_, kNET, "[DHCP] Bound: %u.%u.%u.%u\r\n", config_.ip[0], config_.ip[1],
+              config_.ip[2], config_.ip[3]);
+}
+
+uint32_t DHCPClient::lease_elapsed_s() const {
+  return (System::TimerService::millis() - lease_start_ms_) / 1000;
+}
+
+void DHCPClient::get_ip(uint8_t* ip) const { memcpy(ip, config_.ip, 4); }
+
+void DHCPClient::get_subnet(uint8_t* subnet) const { memcpy(subnet, config_.subnet, 4); }
+
+void DHCPClient::get_gateway(uint8_t* gateway) const { memcpy(gateway, config_.gateway, 4); }
+
+void DHCPClient::get_dns(uint8_t* dns) const { memcpy(dns, config_.dns, 4); }
+
+void DHCPClient::apply_config() {
+  Ethernet::IpAddress ip;
+  Ethernet::SubnetMask subnet;
+  Ethernet::GatewayAddress gateway;
+  memcpy(ip.addr, config_.ip, 4);
+  memcpy(subnet.addr, config_.subnet, 4);
+  memcpy(gateway.addr, config_.gateway, 4);
+  w5500_->set_IP(&ip);
+  w5500_->set_subnet(&subnet);
+  w5500_->set_gateway(&gateway);
+}
+
+bool DHCPClient::load_cache() {
+  LeaseCache cache;
+  eeprom_read_block(&cache, eeprom_ptr(0), sizeof(cache));
+  if (cache.magic != kCacheMagic || memcmp(cache.mac, mac_, 6) != 0 || is_zero(cache.ip)) {
+    return false;
+  }
+
+  memcpy(config_.ip, cache.ip, 4);
+  memcpy(config_.subnet, cache.subnet, 4);
+  memcpy(config_.gateway, cache.gateway, 4);
+  memcpy(config_.dns, cache.dns, 4);
+  memcpy(server_, cache.server, 4);
+  return true;
+}
+
+void DHCPClient::save_cache() {
+  LeaseCache cache;
+  cache.magic = kCacheMagic;
+  memcpy(cache.mac, mac_, 6);
+  memcpy(cache.ip, config_.ip, 4);
+  memcpy(cache.subnet, config_.subnet, 4);
+  memcpy(cache.gateway, config_.gateway, 4);
+  memcpy(cache.dns, config_.dns, 4);
+  memcpy(cache.server, server_, 4);
+  // update_block only writes changed bytes, a renewed lease costs no EEPROM cycles
+  eeprom_update_block(&cache, eeprom_ptr(0), sizeof(cache));
+}
+
+void DHCPClient::invalidate_cache() {
+  uint32_t magic = 0;
+  eeprom_update_block(&magic, eeprom_ptr(offsetof(LeaseCache, magic)), sizeof(magic));
+}
+
+}  // namespace SmartBell
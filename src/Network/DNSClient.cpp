@@ -0,0 +1,390 @@
+#include "Network/DNSClient.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#include <avr/eeprom.h>
+#include <avr/pgmspace.h>
+
+#include "Network/DatagramReader.h"
+#include "System/LogFilter.h"
+#include "System/TimerService.h"
+
+extern "C" {
+#include "W5500/w5500.h"
+#include "socket.h"
+}
+
+namespace SmartBell {
+
+namespace {
+
+constexpr uint16_t kServerPort = 53;
+
+// Header flags: standard query, recursion desired
+constexpr uint8_t kFlagRecursion = 0x01;
+constexpr uint8_t kFlagResponse = 0x80;
+constexpr uint8_t kRcodeMask = 0x0F;
+
+constexpr uint16_t kTypeA = 1;
+constexpr uint16_t kClassIn = 1;
+
+// Cache entry behind the DHCP lease cache (560..589)
+constexpr uint16_t kEepromAddr = 592;
+constexpr uint32_t kRecordMagic = 0x444E5331;  // "DNS1"
+
+struct Record {
+  uint32_t magic;
+  uint8_t ip[4];  // 0.0.0.0: not resolved yet
+  uint32_t ttl;
+  char hostname[DNSClient::kMaxHostnameLength + 1];
+};
+
+void* eeprom_ptr(size_t offset) {
+  return reinterpret_cast<void*>(static_cast<uintptr_t>(kEepromAddr + offset));
+}
+
+bool is_zero(const uint8_t* ip) { return (ip[0] | ip[1] | ip[2] | ip[3]) == 0; }
+
+uint32_t load_be32(const uint8_t* p) {
+  return (static_cast<uint32_t>(p[0]) << 24) | (static_cast<uint32_t>(p[1]) << 16) |
+         (static_cast<uint32_t>(p[2]) << 8) | p[3];
+}
+
+// Letters, digits, '-' and non-empty labels
+bool is_valid_hostname(const char* hostname) {
+  char previous = '.';
+  for (const char* p = hostname; *p != '\0'; p++) {
+    char c = *p;
+    bool label_char = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') ||
+                      c == '-';
+    if (!label_char && !(c == '.' && previous != '.')) {
+      return false;
+    }
+    previous = c;
+  }
+  return previous != '.';
+}
+
+// Skips a (possibly compressed) name in the answer
+bool skip_name(DatagramReader& reader) {
+  uint8_t length;
+  while (reader.read(length)) {
+    if (length == 0) {
+      return true;
+    }
+    if ((length & 0xC0) == 0xC0) {
+      return reader.read(length);  // Pointer: second offset byte ends the name
+    }
+    reader.skip(length);
+  }
+  return false;
+}
+
+void write(const uint8_t* data, uint16_t length) {
+  wiz_send_data(DNSClient::kDNSSocket, const_cast<uint8_t*>(data), length);
+}
+
+}  // namespace
+
+DNSClient::DNSClient(serial::Interface* uart)
+    : uart_(uart),
+      ttl_s_(0),
+      refresh_s_(0),
+      last_query_ms_(0),
+      last_send_ms_(0),
+      query_id_(0),
+      attempts_(0),
+      has_hostname_(false),
+      querying_(false),
+      open_(false) {
+  memset(dns_server_, 0, sizeof(dns_server_));
+  memset(ip_, 0, sizeof(ip_));
+}
+
+void DNSClient::begin() {
+  uint32_t magic;
+  eeprom_read_block(&magic, eeprom_ptr(offsetof(Record, magic)), sizeof(magic));
+  has_hostname_ = (magic == kRecordMagic);
+  if (has_hostname_) {
+    eeprom_read_block(ip_, eeprom_ptr(offsetof(Record, ip)), sizeof(ip_));
+    eeprom_read_block(&ttl_s_, eeprom_ptr(offsetof(Record, ttl)), sizeof(ttl_s_));
+  }
+
+  // Time since the entry was stored is unknown: use it, but refresh right away
+  query_id_ = static_cast<uint16_t>(System::TimerService::millis()) ^ 0x5A5A;
+  last_query_ms_ = System::TimerService::millis();
+  refresh_s_ = 0;
+
+  close(kDNSSocket);
+  open_ = (socket(kDNSSocket, Sn_MR_UDP, 0, 0) == kDNSSocket);
+}
+
+void DNSClient::set_dns_server(const uint8_t* dns_ip) { memcpy(dns_server_, dns_ip, 4); }
+
+DNSResult DNSClient::set_hostname(const char* hostname) {
+  size_t length = strlen(hostname);
+  if (length > kMaxHostnameLength) {
+    return DNSResult::kDomainTooLong;
+  }
+  if (!is_valid_hostname(hostname)) {
+    return DNSResult::kFailed;
+  }
+
+  memset(ip_, 0, sizeof(ip_));
+  ttl_s_ = 0;
+  querying_ = false;
+  has_hostname_ = (length > 0);
+
+  uint32_t magic = 0;
+  eeprom_update_block(&magic, eeprom_ptr(offsetof(Record, magic)), sizeof(magic));
+  if (has_hostname_) {
+    eeprom_update_block(hostname, eeprom_ptr(offsetof(Record, hostname)), length + 1);
+    eeprom_update_block(ip_, eeprom_ptr(offsetof(Record, ip)), sizeof(ip_));
+    eeprom_update_block(&ttl_s_, eeprom_ptr(offsetof(Record, ttl)), sizeof(ttl_s_));
+    magic = kRecordMagic;
+    eeprom_update_block(&magic, eeprom_ptr(offsetof(Record, magic)), sizeof(magic));
+    refresh_s_ = 0;
+  }
+  return DNSResult::kSuccess;
+}
+
+bool DNSClient::run(bool rx_ready) {
+  if (!open_) {
+    return false;
+  }
+
+  bool changed = false;
+  uint8_t ip[4];
+  uint32_t ttl;
+  while (rx_ready && getSn_RX_RSR(kDNSSocket) > 0) {
+    if (!receive_answer(ip, ttl)) {
+      continue;
+    }
+    querying_ = false;
+    if (is_zero(ip)) {
+      SB_LOG_WARN(uart_, kNET, "[DNS] No address for broker host\r\n");
+      query_failed();
+      continue;
+    }
+
+    ttl_s_ = (ttl < kMinTtlS) ? kMinTtlS : (ttl > kMaxTtlS) ? kMaxTtlS : ttl;
+    refresh_s_ = ttl_s_;
+    if (memcmp(ip_, ip, 4) != 0) {
+      memcpy(ip_, ip, 4);
+      changed = true;
+      SB_LOG_INFO(uart_, kNET, "[DNS] Broker: %u.%u.%u.%u\r\n", ip_[0], ip_[1], ip_[2], ip_[3]);
+    }
+    // update_block only writes changed bytes, an unchanged refresh costs no EEPROM cycles
+    eeprom_update_block(ip_, eeprom_ptr(offsetof(Record, ip)), sizeof(ip_));
+    eeprom_update_block(&ttl_s_, eeprom_ptr(offsetof(Record, ttl)), sizeof(ttl_s_));
+  }
+
+  if (!has_hostname_ || is_zero(dns_server_)) {
+    return changed;
+  }
+
+  uint32_t now = System::TimerService::millis();
+  if (querying_) {
+    if ((now - last_send_ms_) >= kRetryMs) {
+      if (++attempts_ >= kMaxAttempts) {
+        SB_LOG_WARN(uart_, kNET, "[DNS] No answer\r\n");
+        query_failed();
+      } else {
+        send_query();
+      }
+    }
+  } else if ((now - last_query_ms_) / 1000 >= refresh_s_) {
+    start_query();
+  }
+  return changed;
+}
+
+void DNSClient::refresh() {
+  if (!querying_ && (System::TimerService::millis() - last_query_ms_) >= kMinRefreshMs) {
+    refresh_s_ = 0;
+  }
+}
+
+bool DNSClient::get_ip(uint8_t* ip_out) const {
+  if (!has_hostname_ || is_zero(ip_)) {
+    return false;
+  }
+  memcpy(ip_out, ip_, 4);
+  return true;
+}
+
+void DNSClient::start_query() {
+  querying_ = true;
+  attempts_ = 0;
+  query_id_++;
+  last_query_ms_ = System::TimerService::millis();
+  send_query();
+}
+
+void DNSClient::query_failed() {
+  // Keep the old address, it is still the best guess
+  querying_ = false;
+  refresh_s_ = kFailRetryS;
+}
+
+void DNSClient::send_query() {
+  setSn_IR(kDNSSocket, Sn_IR_SENDOK | Sn_IR_TIMEOUT);
+
+  // id, flags, 1 question, no answer/authority/additional records
+  uint8_t header[12] = {static_cast<uint8_t>(query_id_ >> 8), static_cast<uint8_t>(query_id_),
+                        kFlagRecursion, 0, 0, 1};
+  write(header, sizeof(header));
+
+  // QNAME: "mqtt.example.com" -> 4 mqtt 7 example 3 com 0
+  char hostname[kMaxHostnameLength + 1];
+  eeprom_read_block(hostname, eeprom_ptr(offsetof(Record, hostname)), sizeof(hostname));
+  hostname[kMaxHostnameLength] = '\0';
+  const char* label = hostname;
+  while (*label != '\0') {
+    const char* end = strchr(label, '.');
+    uint8_t length = static_cast<uint8_t>(end ? end - label : strlen(label));
+    write(&length, 1);
+    write(reinterpret_cast<const uint8_t*>(label), length);
+    label += length + (end ? 1 : 0);
+  }
+
+  const uint8_t question[5] = {0, 0, kTypeA, 0, kClassIn};
+  write(question, sizeof(question));
+
+  setSn_DIPR(kDNSSocket, dns_server_);
+  setSn_DPORT(kDNSSocket, kServerPort);
+  setSn_CR(kDNSSocket, Sn_CR_SEND);
+  while (getSn_CR(kDNSSocket)) {
+  }
+
+  last_send_ms_ = System::TimerService::millis();
+}
+
+bool DNSClient::receive_answer(uint8_t* ip, uint32_t& ttl) {
+  // W5500 UDP header: source ip(4), source port(2), length(2)
+  uint8_t head[8];
+  wiz_recv_data(kDNSSocket, head, sizeof(head));
+  DatagramReader reader(kDNSSocket, (static_cast<uint16_t>(head[6]) << 8) | head[7]);
+  uint16_t source_port = (static_cast<uint16_t>(head[4]) << 8) | head[5];
+
+  memset(ip, 0, 4);
+  uint8_t header[12];
+  bool valid = querying_ && source_port == kServerPort && reader.read(header, sizeof(header)) &&
+               ((static_cast<uint16_t>(header[0]) << 8 | header[1]) == query_id_) &&
+               (header[2] & kFlagResponse) != 0;
+
+  // Only the first A record is used, CNAMEs in front of it are skipped
+  if (valid && (header[3] & kRcodeMask) == 0) {
+    uint16_t questions = (static_cast<uint16_t>(header[4]) << 8) | header[5];
+    uint16_t answers = (static_cast<uint16_t>(header[6]) << 8) | header[7];
+    bool ok = true;
+    while (ok && questions-- > 0) {
+      ok = skip_name(reader);
+      reader.skip(4);  // QTYPE, QCLASS
+    }
+    while (ok && answers-- > 0) {
+      // TYPE(2), CLASS(2), TTL(4), RDLENGTH(2)
+      uint8_t record[10];
+      ok = skip_name(reader) && reader.read(record, sizeof(record));
+      if (!ok) {
+        break;
+      }
+      uint16_t type = (static_cast<uint16_t>(record[0]) << 8) | record[1];
+      uint16_t rclass = (static_cast<uint16_t>(record[2]) << 8) | record[3];
+      uint16_t rdlength = (static_cast<uint16_t>(record[8]) << 8) | record[9];
+      if (type == kTypeA && rclass == kClassIn && rdlength == 4) {
+        uint8_t address[4];
+        if (reader.read(address, sizeof(address))) {
+          memcpy(ip, address, 4);
+          ttl = load_be32(&record[4]);
+        }
+        break;
+      }
+      reader.skip(rdlength);
+    }
+  }
+
+  reader.finish();
+  return valid;
+}
+
+bool DNSClient::process_command(const char* command) {
+  if (strncmp_P(command, PSTR("dns"), 3) != 0 || (command[3] != '\0' && command[3] != ' ')) {
+    return false;
+  }
+  const char* arg = command + 3;
+
+  if (*arg == '\0') {
+    if (!has_hostname_ || uart_ == nullptr) {
+      log(PSTR("Broker host: none\r\n"));
+      return true;
+    }
+    char hostname[kMaxHostnameLength + 1];
+    eeprom_read_block(hostname, eeprom_ptr(offsetof(Record, hostname)), sizeof(hostname));
+    hostname[kMaxHostnameLength] = '\0';
+    log(PSTR("Broker host: "));
+    uart_->send_string(hostname);
+    if (is_zero(ip_)) {
+      log(PSTR("\r\nNot resolved yet\r\n"));
+    } else {
+      log_ip(PSTR("\r\nAddress: "), ip_);
+    }
+    return true;
+  }
+
+  if (strncmp_P(arg, PSTR(" host "), 6) == 0) {
+    const char* hostname = arg + 6;
+    while (*hostname == ' ')
+      hostname++;
+    DNSResult result = (*hostname != '\0') ? set_hostname(hostname) : DNSResult::kFailed;
+    if (result == DNSResult::kSuccess) {
+      log(PSTR("Broker host saved\r\n"));
+    } else if (result == DNSResult::kDomainTooLong) {
+      log(PSTR("Error: Hostname too long (max 31)\r\n"));
+    } else {
+      log(PSTR("Error: Invalid hostname\r\n"));
+    }
+    return true;
+  }
+
+  if (strncmp_P(arg, PSTR(" off"), 4) == 0 && arg[4] == '\0') {
+    set_hostname("");
+    log(PSTR("Broker host cleared\r\n"));
+    return true;
+  }
+
+  log(PSTR("Error: Usage: dns [host <name> | off]\r\n"));
+  return true;
+}
+
+void DNSClient::log(const char* progmem_text) {
+  if (uart_ == nullptr) {
+    return;
+  }
+  char ch;
+  while ((ch = pgm_read_byte(progmem_text++)) != '\0') {
+    uart_->send(static_cast<uint8_t>(ch));
+  }
+}
+
+void DNSClient::log_ip(const char* progmem_label, const uint8_t* ip) {
+  if (uart_ == nullptr) {
+    return;
+  }
+  log(progmem_label);
+  for (uint8_t i = 0; i < 4; i++) {
+    uint8_t value = ip[i];
+    if (value >= 100) {
+      uart_->send('0' + value / 100);
+    }
+    if (value >= 10) {
+      uart_->send('0' + (value / 10) % 10);
+    }
+    uart_->send('0' + value % 10);
+    uart_->send(i < 3 ? '.' : '\r');
+  }
+  uart_->send('\n');
+}
+
+}  // namespace SmartBell
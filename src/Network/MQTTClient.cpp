@@ -20,6 +20,15 @@ namespace SmartBell {
 // Static instance for callbacks
 MQTTClient* MQTTClient::instance_ = nullptr;
 
+namespace {
+
+// ioLibrary client and network state in .bss instead of the heap. There is
+// only one SmartBell::MQTTClient anyway (instance_ serves the C callbacks).
+::MQTTClient client_state;
+::Network network_state;
+
+}  // namespace
+
 // Free function message handler with correct ioLibrary signature
 static void mqtt_message_arrived(MessageData* md) {
   if (MQTTClient::instance_ == nullptr) {
@@ -36,8 +45,6 @@ MQTTClient::MQTTClient(serial::Interface* uart)
       last_disconnect_time_(0),
       reconnect_pending_(false),
       default_callback_(nullptr),
-      mqtt_client_(nullptr),
-      network_(nullptr),
       initialized_(false) {
   memset(send_buffer_, 0, kSendBufferSize);
   memset(recv_buffer_, 0, kRecvBufferSize);
@@ -51,16 +58,6 @@ MQTTClient::~MQTTClient() {
     disconnect();
   }
 
-  // Free allocated structures
-  if (mqtt_client_ != nullptr) {
-    delete static_cast<::MQTTClient*>(mqtt_client_);
-    mqtt_client_ = nullptr;
-  }
-  if (network_ != nullptr) {
-    delete static_cast<::Network*>(network_);
-    network_ = nullptr;
-  }
-
   if (instance_ == this) {
     instance_ = nullptr;
   }
@@ -69,15 +66,9 @@ MQTTClient::~MQTTClient() {
 void MQTTClient::init() {
   log("[MQTT] Initializing...\r\n");
 
-  // Allocate MQTT client and network structures
-  if (mqtt_client_ == nullptr) {
-    mqtt_client_ = new ::MQTTClient();
-    memset(mqtt_client_, 0, sizeof(::MQTTClient));
-  }
-  if (network_ == nullptr) {
-    network_ = new ::Network();
-    memset(network_, 0, sizeof(::Network));
-  }
+  // Reset MQTT client and network structures
+  memset(&client_state, 0, sizeof(client_state));
+  memset(&network_state, 0, sizeof(network_state));
 
   initialized_ = true;
   status_ = MQTTStatus::kDisconnected;
@@ -111,7 +102,7 @@ bool MQTTClient::connect(const MQTTConfig& config, const MQTTCredentials* creden
   configure_wdt::pause();
 
   // Initialize network
-  ::Network* net = static_cast<::Network*>(network_);
+  ::Network* net = &network_state;
   NewNetwork(net, kMQTTSocket);
 
   // Connect network to broker
@@ -126,7 +117,7 @@ bool MQTTClient::connect(const MQTTConfig& config, const MQTTCredentials* creden
   }
 
   // Initialize MQTT client
-  ::MQTTClient* client = static_cast<::MQTTClient*>(mqtt_client_);
+  ::MQTTClient* client = &client_state;
   MQTTClientInit(client, net, kCommandTimeout, send_buffer_, kSendBufferSize, recv_buffer_,
                  kRecvBufferSize);
 
@@ -172,7 +163,7 @@ void MQTTClient::disconnect() {
 
   log("[MQTT] Disconnecting...\r\n");
 
-  ::MQTTClient* client = static_cast<::MQTTClient*>(mqtt_client_);
+  ::MQTTClient* client = &client_state;
   MQTTDisconnect(client);
 
   // Close socket
@@ -185,10 +176,10 @@ void MQTTClient::disconnect() {
 }
 
 bool MQTTClient::is_connected() const {
-  if (!initialized_ || mqtt_client_ == nullptr) {
+  if (!initialized_) {
     return false;
   }
-  ::MQTTClient* client = static_cast<::MQTTClient*>(mqtt_client_);
+  ::MQTTClient* client = &client_state;
   return client->isconnected != 0;
 }
 
@@ -214,7 +205,7 @@ bool MQTTClient::publish(const char* topic, const uint8_t* payload, uint16_t len
   message.payload = const_cast<uint8_t*>(payload);
   message.payloadlen = length;
 
-  ::MQTTClient* client = static_cast<::MQTTClient*>(mqtt_client_);
+  ::MQTTClient* client = &client_state;
   int rc = MQTTPublish(client, topic, &message);
 
   configure_wdt::reset();
@@ -254,7 +245,7 @@ bool MQTTClient::subscribe(const char* topic, MQTTMessageCallback callback, MQTT
 
   configure_wdt::reset();
 
-  ::MQTTClient* client = static_cast<::MQTTClient*>(mqtt_client_);
+  ::MQTTClient* client = &client_state;
   int rc = MQTTSubscribe(client, topic, static_cast<enum QoS>(static_cast<uint8_t>(qos)),
                          mqtt_message_arrived);
 
@@ -278,7 +269,7 @@ bool MQTTClient::unsubscribe(const char* topic) {
   log(topic);
   log("\r\n");
 
-  ::MQTTClient* client = static_cast<::MQTTClient*>(mqtt_client_);
+  ::MQTTClient* client = &client_state;
   int rc = MQTTUnsubscribe(client, topic);
 
   if (rc != 0) {
@@ -296,7 +287,7 @@ bool MQTTClient::yield(uint32_t timeout_ms) {
 
   configure_wdt::reset();
 
-  ::MQTTClient* client = static_cast<::MQTTClient*>(mqtt_client_);
+  ::MQTTClient* client = &client_state;
   int rc = MQTTYield(client, static_cast<int>(timeout_ms));
 
   configure_wdt::reset();
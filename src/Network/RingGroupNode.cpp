@@ -0,0 +1,306 @@
+#include "Network/RingGroupNode.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#include <avr/eeprom.h>
+#include <avr/pgmspace.h>
+
+#include "Serial/Interface.h"
+
+extern "C" {
+#include "W5500/w5500.h"
+#include "socket.h"
+}
+
+namespace Network {
+
+namespace {
+
+// Own record behind the SmartBellConfig (EEPROM 128..~360), so config
+// layout changes never touch group key and epoch
+constexpr uint16_t kEepromAddr = 512;
+constexpr uint32_t kRecordMagic = 0x52494E47;  // "RING"
+constexpr uint8_t kKeySet = 0x4B;              // 'K', written by "ring key" only
+
+struct Record {
+  uint32_t magic;
+  uint16_t epoch;
+  uint8_t group;
+  uint8_t key[RingGroup::kKeyLength];
+  uint8_t key_state;  // kKeySet, anything else: erased key (0xFF..), never used
+};
+
+// Replay floors (highest accepted sequence per DedupeWindow slot) behind the
+// DNS record (592..635). Updated on every accepted ring, only changed bytes
+// are written, rings are rare enough for the EEPROM endurance.
+constexpr uint16_t kFloorEepromAddr = 640;
+constexpr uint8_t kFloorUsed = 0x5A;
+
+struct Floor {
+  uint16_t sender;
+  uint32_t highest;
+  uint8_t used;  // kFloorUsed, anything else: empty (erased EEPROM)
+};
+
+void* floor_ptr(uint8_t index) {
+  return reinterpret_cast<void*>(static_cast<uintptr_t>(kFloorEepromAddr + index * sizeof(Floor)));
+}
+
+// Administratively scoped multicast group and its MAC (01:00:5e + low 23 bits)
+const uint8_t kMulticastIp[4] = {239, 255, 42, 1};
+const uint8_t kMulticastMac[6] = {0x01, 0x00, 0x5E, 0x7F, 0x2A, 0x01};
+
+void* eeprom_ptr(size_t offset) {
+  return reinterpret_cast<void*>(static_cast<uintptr_t>(kEepromAddr + offset));
+}
+
+int8_t hex_value(char c) {
+  if (c >= '0' && c <= '9')
+    return c - '0';
+  if (c >= 'a' && c <= 'f')
+    return c - 'a' + 10;
+  if (c >= 'A' && c <= 'F')
+    return c - 'A' + 10;
+  return -1;
+}
+
+}  // namespace
+
+RingGroupNode::RingGroupNode(serial::Interface& uart)
+    : uart_(&uart),
+      callback_(nullptr),
+      sequence_(0),
+      sender_(0),
+      group_(0),
+      key_set_(false),
+      open_(false) {}
+
+bool RingGroupNode::begin(const uint8_t* mac, RingCallback callback) {
+  callback_ = callback;
+  sender_ = (static_cast<uint16_t>(mac[4]) << 8) | mac[5];
+
+  uint32_t magic;
+  eeprom_read_block(&magic, eeprom_ptr(offsetof(Record, magic)), sizeof(magic));
+  if (magic != kRecordMagic) {
+    group_ = 0;
+    return false;
+  }
+  eeprom_read_block(&group_, eeprom_ptr(offsetof(Record, group)), sizeof(group_));
+  uint8_t key_state;
+  eeprom_read_block(&key_state, eeprom_ptr(offsetof(Record, key_state)), sizeof(key_state));
+  key_set_ = (key_state == kKeySet);
+
+  // New epoch per boot: sequences stay ahead of everything sent before
+  advance_epoch();
+  restore_floors();
+
+  return open_socket();
+}
+
+void RingGroupNode::end() {
+  if (open_) {
+    close(kSocketNumber);
+    open_ = false;
+  }
+}
+
+bool RingGroupNode::open_socket() {
+  end();
+  if (group_ == 0) {
+    return false;
+  }
+  // An erased key is public: without "ring key" nothing is sent or accepted
+  if (!key_set_) {
+    msg_ptr(PSTR("[RING] No key set, group stays closed\r\n"));
+    return false;
+  }
+
+  // Multicast: destination must be set before OPEN, the W5500 sends the IGMP join
+  setSn_DIPR(kSocketNumber, const_cast<uint8_t*>(kMulticastIp));
+  setSn_DHAR(kSocketNumber, const_cast<uint8_t*>(kMulticastMac));
+  setSn_DPORT(kSocketNumber, kPort);
+  if (socket(kSocketNumber, Sn_MR_UDP, kPort, SF_MULTI_ENABLE) != kSocketNumber) {
+    msg_ptr(PSTR("[RING] Socket open failed\r\n"));
+    return false;
+  }
+
+  open_ = true;
+  return true;
+}
+
+bool RingGroupNode::send_ring(uint8_t gong_mask) {
+  if (!open_) {
+    return false;
+  }
+
+  if ((sequence_ & 0xFFFF) == 0xFFFF) {
+    advance_epoch();
+  }
+  sequence_++;
+
+  RingGroup::Datagram datagram = {group_, sender_, gong_mask, sequence_};
+  uint8_t key[RingGroup::kKeyLength];
+  uint8_t buffer[RingGroup::kDatagramLength];
+  read_key(key);
+  RingGroup::encode(datagram, key, buffer);
+  memset(key, 0, sizeof(key));
+
+  int32_t sent = sendto(kSocketNumber, buffer, sizeof(buffer), const_cast<uint8_t*>(kMulticastIp),
+                        kPort);
+  return (sent == static_cast<int32_t>(sizeof(buffer)));
+}
+
+void RingGroupNode::loop() {
+  // Drain everything: with poll() the next RECV event only comes with new data
+  while (open_ && getSn_RX_RSR(kSocketNumber) > 0) {
+    uint8_t buffer[RingGroup::kDatagramLength];
+    uint8_t from_ip[4];
+    uint16_t from_port;
+    int32_t len = recvfrom(kSocketNumber, buffer, sizeof(buffer), from_ip, &from_port);
+    if (len <= 0) {
+      return;
+    }
+
+    uint8_t key[RingGroup::kKeyLength];
+    RingGroup::Datagram datagram;
+    read_key(key);
+    bool valid = RingGroup::decode(buffer, static_cast<uint16_t>(len), key, datagram);
+    memset(key, 0, sizeof(key));
+
+    if (!valid || datagram.group != group_ || datagram.sender == sender_) {
+      continue;
+    }
+    if (!dedupe_.accept(datagram.sender, datagram.sequence)) {
+      continue;
+    }
+    save_floors();
+
+    msg_ptr(PSTR("[RING] Ring from group\r\n"));
+    if (callback_ != nullptr) {
+      callback_(datagram.gong_mask);
+    }
+  }
+}
+
+bool RingGroupNode::process_command(const char* command) {
+  if (strncmp_P(command, PSTR("ring"), 4) != 0) {
+    return false;
+  }
+  const char* arg = command + 4;
+
+  if (*arg == '\0') {
+    if (group_ == 0) {
+      msg_ptr(PSTR("Ring group: off\r\n"));
+    } else if (!key_set_) {
+      msg_ptr(PSTR("Ring group: closed, no key (ring key <32 hex>)\r\n"));
+    } else {
+      msg_ptr(open_ ? PSTR("Ring group: on\r\n") : PSTR("Ring group: socket error\r\n"));
+    }
+    return true;
+  }
+
+  if (strncmp_P(arg, PSTR(" group "), 7) == 0) {
+    uint16_t group = 0;
+    const char* p = arg + 7;
+    while (*p >= '0' && *p <= '9' && group <= 255) {
+      group = group * 10 + (*p++ - '0');
+    }
+    if (*p != '\0' || p == arg + 7 || group > 255) {
+      msg_ptr(PSTR("Error: Usage: ring group <0-255>\r\n"));
+      return true;
+    }
+    group_ = static_cast<uint8_t>(group);
+    save_record();
+    open_socket();
+    msg_ptr(PSTR("Ring group saved\r\n"));
+    return true;
+  }
+
+  if (strncmp_P(arg, PSTR(" key "), 5) == 0) {
+    const char* hex = arg + 5;
+    uint8_t key[RingGroup::kKeyLength];
+    for (uint8_t i = 0; i < RingGroup::kKeyLength; i++) {
+      int8_t high = hex_value(hex[2 * i]);
+      int8_t low = (high < 0) ? -1 : hex_value(hex[2 * i + 1]);
+      if (low < 0) {
+        msg_ptr(PSTR("Error: Usage: ring key <32 hex digits>\r\n"));
+        return true;
+      }
+      key[i] = static_cast<uint8_t>((high << 4) | low);
+    }
+    eeprom_update_block(key, eeprom_ptr(offsetof(Record, key)), sizeof(key));
+    memset(key, 0, sizeof(key));
+    uint8_t key_state = kKeySet;
+    eeprom_update_block(&key_state, eeprom_ptr(offsetof(Record, key_state)), sizeof(key_state));
+    key_set_ = true;
+    save_record();
+    open_socket();
+    msg_ptr(PSTR("Ring key saved\r\n"));
+    return true;
+  }
+
+  msg_ptr(PSTR("Error: Usage: ring [group <n> | key <hex>]\r\n"));
+  return true;
+}
+
+void RingGroupNode::read_key(uint8_t* key) {
+  eeprom_read_block(key, eeprom_ptr(offsetof(Record, key)), RingGroup::kKeyLength);
+}
+
+void RingGroupNode::save_record() {
+  uint32_t magic;
+  eeprom_read_block(&magic, eeprom_ptr(offsetof(Record, magic)), sizeof(magic));
+  bool created = (magic != kRecordMagic);
+  magic = kRecordMagic;
+  eeprom_update_block(&group_, eeprom_ptr(offsetof(Record, group)), sizeof(group_));
+  eeprom_update_block(&magic, eeprom_ptr(offsetof(Record, magic)), sizeof(magic));
+  if (created) {
+    // begin() skipped the epoch without a record, this session must not send
+    // from epoch 0 or the next boot would repeat its sequences
+    advance_epoch();
+  }
+}
+
+void RingGroupNode::restore_floors() {
+  for (uint8_t i = 0; i < RingGroup::kMaxPeers; i++) {
+    Floor floor;
+    eeprom_read_block(&floor, floor_ptr(i), sizeof(floor));
+    if (floor.used == kFloorUsed) {
+      dedupe_.restore(floor.sender, floor.highest);
+    }
+  }
+}
+
+void RingGroupNode::save_floors() {
+  for (uint8_t i = 0; i < RingGroup::kMaxPeers; i++) {
+    Floor floor = {0, 0, 0};
+    if (dedupe_.peer(i, floor.sender, floor.highest)) {
+      floor.used = kFloorUsed;
+    }
+    eeprom_update_block(&floor, floor_ptr(i), sizeof(floor));
+  }
+}
+
+void RingGroupNode::advance_epoch() {
+  uint16_t epoch;
+  eeprom_read_block(&epoch, eeprom_ptr(offsetof(Record, epoch)), sizeof(epoch));
+  // 0xFFFF is erased EEPROM: unset, the first epoch is 1 (never wrap to 0).
+  // 0xFFFE is the last one (a reboot per day for ~180 years)
+  if (epoch == 0xFFFF) {
+    epoch = 1;
+  } else if (epoch < 0xFFFE) {
+    epoch++;
+  }
+  eeprom_update_block(&epoch, eeprom_ptr(offsetof(Record, epoch)), sizeof(epoch));
+  sequence_ = static_cast<uint32_t>(epoch) << 16;
+}
+
+void RingGroupNode::msg_ptr(const char* progmem_text) {
+  char ch;
+  while ((ch = pgm_read_byte(progmem_text++)) != '\0') {
+    uart_->send(static_cast<uint8_t>(ch));
+  }
+}
+
+}  // namespace Network
@@ -0,0 +1,168 @@
+#include "Network/RingGroupProtocol.h"
+
+#include <string.h>
+
+namespace Network {
+namespace RingGroup {
+
+namespace {
+
+constexpr uint32_t kXteaDelta = 0x9E3779B9UL;
+constexpr uint8_t kXteaCycles = 32;
+
+uint32_t load_be32(const uint8_t* p) {
+  return (static_cast<uint32_t>(p[0]) << 24) | (static_cast<uint32_t>(p[1]) << 16) |
+         (static_cast<uint32_t>(p[2]) << 8) | p[3];
+}
+
+void store_be32(uint8_t* p, uint32_t value) {
+  p[0] = (value >> 24) & 0xFF;
+  p[1] = (value >> 16) & 0xFF;
+  p[2] = (value >> 8) & 0xFF;
+  p[3] = value & 0xFF;
+}
+
+// Encrypts one 64-bit block in place
+void xtea_encrypt(uint32_t& v0, uint32_t& v1, const uint32_t* k) {
+  uint32_t sum = 0;
+  for (uint8_t i = 0; i < kXteaCycles; i++) {
+    v0 += (((v1 << 4) ^ (v1 >> 5)) + v1) ^ (sum + k[sum & 3]);
+    sum += kXteaDelta;
+    v1 += (((v0 << 4) ^ (v0 >> 5)) + v0) ^ (sum + k[(sum >> 11) & 3]);
+  }
+}
+
+}  // namespace
+
+void compute_tag(const uint8_t* data, const uint8_t* key, uint8_t* tag) {
+  uint32_t k[4];
+  for (uint8_t i = 0; i < 4; i++) {
+    k[i] = load_be32(&key[i * 4]);
+  }
+
+  // 12 bytes zero-padded to two 8-byte blocks
+  uint8_t block[16] = {};
+  memcpy(block, data, kSignedLength);
+
+  uint32_t v0 = 0;
+  uint32_t v1 = 0;
+  for (uint8_t offset = 0; offset < sizeof(block); offset += 8) {
+    v0 ^= load_be32(&block[offset]);
+    v1 ^= load_be32(&block[offset + 4]);
+    xtea_encrypt(v0, v1, k);
+  }
+
+  store_be32(tag, v0);
+}
+
+void encode(const Datagram& datagram, const uint8_t* key, uint8_t* out) {
+  out[0] = kMagic0;
+  out[1] = kMagic1;
+  out[2] = kVersion;
+  out[3] = datagram.group;
+  out[4] = (datagram.sender >> 8) & 0xFF;
+  out[5] = datagram.sender & 0xFF;
+  out[6] = datagram.gong_mask;
+  out[7] = 0;  // Flags, reserved
+  store_be32(&out[8], datagram.sequence);
+  compute_tag(out, key, &out[kSignedLength]);
+}
+
+bool decode(const uint8_t* data, uint16_t length, const uint8_t* key, Datagram& datagram) {
+  if (length != kDatagramLength || data[0] != kMagic0 || data[1] != kMagic1 ||
+      data[2] != kVersion) {
+    return false;
+  }
+
+  uint8_t tag[kTagLength];
+  compute_tag(data, key, tag);
+  // Constant time compare, no early exit on the first wrong byte
+  uint8_t diff = 0;
+  for (uint8_t i = 0; i < kTagLength; i++) {
+    diff |= tag[i] ^ data[kSignedLength + i];
+  }
+  if (diff != 0) {
+    return false;
+  }
+
+  datagram.group = data[3];
+  datagram.sender = (static_cast<uint16_t>(data[4]) << 8) | data[5];
+  datagram.gong_mask = data[6];
+  datagram.sequence = load_be32(&data[8]);
+  return true;
+}
+
+DedupeWindow::DedupeWindow() : next_victim_(0) { memset(peers_, 0, sizeof(peers_)); }
+
+DedupeWindow::Peer* DedupeWindow::claim(uint16_t sender, bool& known) {
+  Peer* free_slot = nullptr;
+  for (uint8_t i = 0; i < kMaxPeers; i++) {
+    if (peers_[i].used && peers_[i].sender == sender) {
+      known = true;
+      return &peers_[i];
+    }
+    if (!peers_[i].used && free_slot == nullptr) {
+      free_slot = &peers_[i];
+    }
+  }
+
+  known = false;
+  if (free_slot == nullptr) {
+    free_slot = &peers_[next_victim_];
+    next_victim_ = (next_victim_ + 1) % kMaxPeers;
+  }
+  free_slot->used = true;
+  free_slot->sender = sender;
+  return free_slot;
+}
+
+bool DedupeWindow::accept(uint16_t sender, uint32_t sequence) {
+  bool known;
+  Peer* peer = claim(sender, known);
+  if (!known) {
+    peer->highest = sequence;
+    peer->seen = 0;
+    return true;
+  }
+
+  if (sequence > peer->highest) {
+    uint32_t shift = sequence - peer->highest;
+    // Old highest becomes bit (shift - 1) of the window
+    peer->seen = (shift > kDedupeWindow)
+                     ? 0
+                     : static_cast<uint8_t>((peer->seen << shift) | (1U << (shift - 1)));
+    peer->highest = sequence;
+    return true;
+  }
+
+  uint32_t age = peer->highest - sequence;
+  if (age == 0 || age > kDedupeWindow) {
+    return false;  // Duplicate of the newest, or too old to tell: replay
+  }
+
+  uint8_t bit = static_cast<uint8_t>(1U << (age - 1));
+  if (peer->seen & bit) {
+    return false;
+  }
+  peer->seen |= bit;
+  return true;
+}
+
+void DedupeWindow::restore(uint16_t sender, uint32_t floor) {
+  bool known;
+  Peer* peer = claim(sender, known);
+  peer->highest = floor;
+  peer->seen = 0xFF;  // The window below the floor is unknown: treat as seen
+}
+
+bool DedupeWindow::peer(uint8_t index, uint16_t& sender, uint32_t& highest) const {
+  if (index >= kMaxPeers || !peers_[index].used) {
+    return false;
+  }
+  sender = peers_[index].sender;
+  highest = peers_[index].highest;
+  return true;
+}
+
+}  // namespace RingGroup
+}  // namespace Network
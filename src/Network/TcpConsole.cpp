@@ -0,0 +1,170 @@
+#include "Network/TcpConsole.h"
+
+#include <avr/pgmspace.h>
+
+extern "C" {
+#include "W5500/w5500.h"
+#include "socket.h"
+}
+
+namespace Network {
+
+namespace {
+
+const char kGreeting[] PROGMEM = "Smart Bell console, 'help' for commands\r\n";
+
+}  // namespace
+
+TcpConsole::TcpConsole(serial::Interface& uart)
+    : uart_(&uart),
+      tx_length_(0),
+      tx_unsent_(0),
+      send_in_flight_(false),
+      connected_(false),
+      open_(false) {}
+
+bool TcpConsole::begin() {
+  listen_socket();
+  return open_;
+}
+
+void TcpConsole::listen_socket() {
+  connected_ = false;
+  tx_length_ = 0;
+  tx_unsent_ = 0;
+  send_in_flight_ = false;
+  close(kSocketNumber);
+  open_ = (socket(kSocketNumber, Sn_MR_TCP, kPort, 0) == kSocketNumber) &&
+          (listen(kSocketNumber) == SOCK_OK);
+}
+
+void TcpConsole::drop_client() {
+  if (open_ && connected_) {
+    listen_socket();
+  }
+}
+
+void TcpConsole::loop() {
+  if (!open_) {
+    return;
+  }
+
+  switch (getSn_SR(kSocketNumber)) {
+    case SOCK_ESTABLISHED:
+      if (!connected_) {
+        setSn_IR(kSocketNumber, Sn_IR_CON);
+        connected_ = true;
+        char ch;
+        const char* p = kGreeting;
+        while ((ch = pgm_read_byte(p++)) != '\0') {
+          send(static_cast<uint8_t>(ch));
+        }
+      }
+      flush();
+      break;
+
+    case SOCK_CLOSE_WAIT:
+      // Client closed: send what is left, then back to LISTEN
+      flush();
+      if (tx_length_ == 0 && tx_unsent_ == 0 && !send_in_flight_) {
+        disconnect(kSocketNumber);
+        listen_socket();
+      }
+      break;
+
+    case SOCK_LISTEN:
+    case SOCK_SYNRECV:
+      break;
+
+    default:
+      // CLOSED or a TCP timeout
+      listen_socket();
+      break;
+  }
+}
+
+void TcpConsole::send(const uint8_t byte) {
+  uart_->send(byte);
+  if (!connected_) {
+    return;
+  }
+
+  if (tx_length_ == kTxChunkLength) {
+    flush();
+    if (tx_length_ == kTxChunkLength) {
+      return;  // TX buffer full, the client does not read
+    }
+  }
+  tx_[tx_length_++] = byte;
+  if (tx_length_ == kTxChunkLength || byte == '\n') {
+    flush();
+  }
+}
+
+void TcpConsole::send_bytes(const uint8_t* const bytes, const uint16_t length) {
+  for (uint16_t i = 0; i < length; i++) {
+    send(bytes[i]);
+  }
+}
+
+void TcpConsole::send_string(const char* string) {
+  while (*string != '\0') {
+    send(static_cast<uint8_t>(*string++));
+  }
+}
+
+bool TcpConsole::is_read_data_available() const {
+  return connected_ && getSn_RX_RSR(kSocketNumber) > 0;
+}
+
+uint8_t TcpConsole::read_byte() {
+  uint8_t byte = 0;
+  if (::recv(kSocketNumber, &byte, 1) != 1) {
+    return 0;
+  }
+  return byte;
+}
+
+void TcpConsole::flush() {
+  service_send();
+  if (tx_length_ == 0) {
+    return;
+  }
+  uint8_t status = getSn_SR(kSocketNumber);
+  if (status != SOCK_ESTABLISHED && status != SOCK_CLOSE_WAIT) {
+    // Connection gone, loop() reopens the socket
+    connected_ = false;
+    tx_length_ = 0;
+    return;
+  }
+  // No ::send(): it returns SOCK_BUSY until the previous SENDOK, which is the
+  // normal case for multi-line output. The chunk waits in tx_ if it does not fit
+  if (getSn_TX_FSR(kSocketNumber) < tx_unsent_ + tx_length_) {
+    return;
+  }
+  wiz_send_data(kSocketNumber, tx_, tx_length_);
+  tx_unsent_ += tx_length_;
+  tx_length_ = 0;
+  service_send();
+}
+
+void TcpConsole::service_send() {
+  if (send_in_flight_) {
+    // Sn_IR_TIMEOUT closes the socket, loop() sees that in the status
+    if ((getSn_IR(kSocketNumber) & Sn_IR_SENDOK) == 0) {
+      return;
+    }
+    setSn_IR(kSocketNumber, Sn_IR_SENDOK);
+    send_in_flight_ = false;
+  }
+  if (tx_unsent_ == 0) {
+    return;
+  }
+  setSn_CR(kSocketNumber, Sn_CR_SEND);
+  while (getSn_CR(kSocketNumber)) {
+  }
+  tx_unsent_ = 0;
+  send_in_flight_ = true;
+}
+
+}  // namespace Network
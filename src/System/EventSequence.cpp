@@ -0,0 +1,67 @@
+#include "System/EventSequence.h"
+
+#ifdef __AVR__
+#include <avr/eeprom.h>
+#endif
+
+namespace System {
+
+namespace {
+
+constexpr uint16_t kStateMagic = 0x5E90;
+
+// Behind the ring group record (512..534)
+constexpr uint16_t kBootIdEepromAddr = 544;
+
+// Not touched by the C runtime startup, keeps its value across resets
+struct State {
+  uint32_t sequence;
+  uint16_t boot_id;
+  uint16_t magic;
+  uint16_t boot_id_check;  // ~boot_id
+};
+
+#ifdef __AVR__
+State g_state __attribute__((section(".noinit")));
+#else
+State g_state;
+uint16_t g_stored_boot_id = 0;  // Host build: stands in for the EEPROM cell
+#endif
+
+uint16_t take_boot_id() {
+  uint16_t boot_id;
+#ifdef __AVR__
+  boot_id = eeprom_read_word(reinterpret_cast<uint16_t*>(kBootIdEepromAddr)) + 1;
+  eeprom_update_word(reinterpret_cast<uint16_t*>(kBootIdEepromAddr), boot_id);
+#else
+  boot_id = ++g_stored_boot_id;
+#endif
+  return boot_id;
+}
+
+}  // namespace
+
+void EventSequence::init(bool cold_boot) {
+  bool valid = (g_state.magic == kStateMagic) &&
+               (g_state.boot_id_check == static_cast<uint16_t>(~g_state.boot_id));
+  if (cold_boot || !valid) {
+    g_state.boot_id = take_boot_id();
+    g_state.boot_id_check = ~g_state.boot_id;
+    g_state.sequence = 0;
+    g_state.magic = kStateMagic;
+  }
+}
+
+uint32_t EventSequence::next() { return ++g_state.sequence; }
+
+uint16_t EventSequence::boot_id() { return g_state.boot_id; }
+
+EventEnvelope EventSequence::envelope(uint32_t sequence, uint32_t age_ms) {
+  EventEnvelope event;
+  event.boot_id = g_state.boot_id;
+  event.sequence = sequence;
+  event.age_ms = (age_ms > 0xFFFF) ? 0xFFFF : static_cast<uint16_t>(age_ms);
+  return event;
+}
+
+}  // namespace System
@@ -0,0 +1,86 @@
+#include "System/LogFilter.h"
+
+#include "Utils/ProgmemStrings.h"
+
+namespace System {
+
+uint8_t g_log_mask = kLogMaskAll;
+
+namespace {
+
+// Same order as LogModule
+const char kModuleNames[kLogModuleCount][5] PROGMEM = {"mqtt", "net", "cfg", "bell", "app"};
+
+// Compares the RAM word at @p text (ended by ' ' or '\0') with a PROGMEM name
+bool word_equals_P(const char* text, const char* progmem_name) {
+  char c;
+  while ((c = pgm_read_byte(progmem_name++)) != '\0') {
+    if (*text++ != c) {
+      return false;
+    }
+  }
+  return *text == '\0' || *text == ' ';
+}
+
+const char* skip_word(const char* text) {
+  while (*text != '\0' && *text != ' ') {
+    text++;
+  }
+  while (*text == ' ') {
+    text++;
+  }
+  return text;
+}
+
+void print_modules(serial::Interface& out) {
+  for (uint8_t i = 0; i < kLogModuleCount; i++) {
+    Utils::print_P(&out, kModuleNames[i]);
+    Utils::print_P(&out, PSTR_STORED(" level "));
+    out.send(static_cast<uint8_t>('0' + kLogLevels[i]));
+    if (kLogLevels[i] == 0) {
+      Utils::print_P(&out, PSTR_STORED("\r\n"));
+    } else if (g_log_mask & (1 << i)) {
+      Utils::print_P(&out, PSTR_STORED(" on\r\n"));
+    } else {
+      Utils::print_P(&out, PSTR_STORED(" off\r\n"));
+    }
+  }
+}
+
+}  // namespace
+
+bool process_log_command(const char* command, serial::Interface& out) {
+  if (!word_equals_P(command, PSTR_STORED("log"))) {
+    return false;
+  }
+  const char* module = skip_word(command);
+  if (*module == '\0') {
+    print_modules(out);
+    return true;
+  }
+
+  uint8_t bits = 0;
+  if (word_equals_P(module, PSTR_STORED("all"))) {
+    bits = kLogMaskAll;
+  } else {
+    for (uint8_t i = 0; i < kLogModuleCount; i++) {
+      if (word_equals_P(module, kModuleNames[i])) {
+        bits = 1 << i;
+      }
+    }
+  }
+
+  const char* state = skip_word(module);
+  if (bits != 0 && word_equals_P(state, PSTR_STORED("on"))) {
+    g_log_mask |= bits;
+  } else if (bits != 0 && word_equals_P(state, PSTR_STORED("off"))) {
+    g_log_mask &= ~bits;
+  } else {
+    Utils::print_P(&out, PSTR_STORED("Usage: log [mqtt|net|cfg|bell|app|all on|off]\r\n"));
+    return true;
+  }
+  print_modules(out);
+  return true;
+}
+
+}  // namespace System
@@ -0,0 +1,86 @@
+#include "System/StackMonitor.h"
+
+#include <string.h>
+
+#include "System/TokenLog.h"
+#include "Utils/FlashString.h"
+#include "Utils/ProgmemStrings.h"
+
+#ifdef __AVR__
+#include <avr/io.h>
+
+// Linker symbols of the default avr5 script
+extern uint8_t __data_start;
+extern uint8_t __data_end;
+extern uint8_t __bss_start;
+extern uint8_t __bss_end;
+extern uint8_t __heap_start;
+#ifndef NO_HEAP
+extern char* __brkval;  // malloc break, nullptr until the first allocation
+#endif
+
+// Runs in .init1, before SP and r1 are set up and before .data/.bss are
+// initialized, so plain asm only: fills _end .. __stack with kStackPaint.
+// Linked together with process_mem_command(), no painting without the command.
+extern "C" void paint_stack() __attribute__((naked, used, section(".init1")));
+
+extern "C" void paint_stack() {
+  __asm__ volatile(
+      "    ldi r30, lo8(_end)\n"
+      "    ldi r31, hi8(_end)\n"
+      "    ldi r24, %0\n"
+      "    ldi r25, hi8(__stack)\n"
+      "    rjmp 2f\n"
+      "1:  st Z+, r24\n"
+      "2:  cpi r30, lo8(__stack)\n"
+      "    cpc r31, r25\n"
+      "    brlo 1b\n"
+      "    breq 1b\n" ::"M"(System::kStackPaint));
+}
+#endif
+
+namespace System {
+
+uint16_t count_painted(const uint8_t* begin, const uint8_t* end) {
+  const uint8_t* p = begin;
+  while (p < end && *p == kStackPaint) {
+    p++;
+  }
+  return static_cast<uint16_t>(p - begin);
+}
+
+MemoryStats memory_stats() {
+  MemoryStats stats;
+  memset(&stats, 0, sizeof(stats));
+#ifdef __AVR__
+  stats.data_size = static_cast<uint16_t>(&__data_end - &__data_start);
+  stats.bss_size = static_cast<uint16_t>(&__bss_end - &__bss_start);
+
+  const uint8_t* heap_end = &__heap_start;
+#ifndef NO_HEAP
+  if (__brkval != nullptr) {
+    heap_end = reinterpret_cast<const uint8_t*>(__brkval);
+  }
+#endif
+  stats.heap_used = static_cast<uint16_t>(heap_end - &__heap_start);
+
+  const uint8_t* sp = reinterpret_cast<const uint8_t*>(SP);
+  stats.stack_free_now = static_cast<uint16_t>(sp - heap_end);
+  stats.stack_free_min = count_painted(heap_end, sp);
+#endif
+  return stats;
+}
+
+bool process_mem_command(const char* command, serial::Interface& out) {
+  if (Utils::flash_compare(command, FSTR("mem")) != 0) {
+    return false;
+  }
+  MemoryStats stats = memory_stats();
+  log_text(&out, PSTR_STORED("data %u bss %u heap %u\r\n"), stats.data_size, stats.bss_size,
+           stats.heap_used);
+  log_text(&out, PSTR_STORED("stack free %u min %u\r\n"), stats.stack_free_now,
+           stats.stack_free_min);
+  return true;
+}
+
+}  // namespace System
@@ -0,0 +1,88 @@
+#include "System/TokenLog.h"
+
+#include "System/TimerService.h"
+
+namespace System {
+
+namespace {
+
+void send_number(serial::Interface* out, uint32_t value, uint8_t base) {
+  char buffer[11];
+  uint8_t i = sizeof(buffer) - 1;
+  buffer[i] = '\0';
+  do {
+    uint8_t digit = value % base;
+    buffer[--i] = static_cast<char>(digit < 10 ? '0' + digit : 'a' + digit - 10);
+    value /= base;
+  } while (value > 0);
+  out->send_string(&buffer[i]);
+}
+
+}  // namespace
+
+uint8_t encode_varint(uint32_t value, uint8_t* out) {
+  uint8_t length = 0;
+  while (value >= 0x80) {
+    out[length++] = static_cast<uint8_t>(value) | 0x80;
+    value >>= 7;
+  }
+  out[length++] = static_cast<uint8_t>(value);
+  return length;
+}
+
+uint8_t encode_log_frame(uint16_t token, uint32_t timestamp_ms, const uint32_t* args,
+                         uint8_t arg_count, uint8_t* out) {
+  if (arg_count > kMaxLogArgs) {
+    arg_count = kMaxLogArgs;
+  }
+  uint8_t pos = 2;
+  pos += encode_varint(token, &out[pos]);
+  pos += encode_varint(timestamp_ms, &out[pos]);
+  for (uint8_t i = 0; i < arg_count; i++) {
+    pos += encode_varint(args[i], &out[pos]);
+  }
+  out[0] = kLogFrameStart;
+  out[1] = pos - 2;
+  return pos;
+}
+
+void write_log_frame(serial::Interface* out, uint16_t token, const uint32_t* args,
+                     uint8_t arg_count) {
+  if (out == nullptr) {
+    return;
+  }
+  uint8_t frame[kMaxLogFrameSize];
+  uint8_t size = encode_log_frame(token, TimerService::millis(), args, arg_count, frame);
+  out->send_bytes(frame, size);
+}
+
+void write_log_text(serial::Interface* out, const char* progmem_format, const uint32_t* args,
+                    uint8_t arg_count) {
+  if (out == nullptr) {
+    return;
+  }
+  uint8_t next = 0;
+  char c;
+  while ((c = pgm_read_byte(progmem_format++)) != '\0') {
+    char spec = (c == '%') ? pgm_read_byte(progmem_format) : '\0';
+    if (spec != 'u' && spec != 'd' && spec != 'x') {
+      out->send(static_cast<uint8_t>(c));
+      continue;
+    }
+    progmem_format++;
+    uint32_t value = (next < arg_count) ? args[next] : 0;
+    next++;
+    if (spec == 'd') {
+      // Undo the zigzag encoding of log_arg()
+      if (value & 1) {
+        out->send('-');
+        value = (value >> 1) + 1;
+      } else {
+        value >>= 1;
+      }
+    }
+    send_number(out, value, spec == 'x' ? 16 : 10);
+  }
+}
+
+}  // namespace System
@@ -0,0 +1,18 @@
+#ifdef __AVR__
+#include <stdint.h>
+
+// C++ Guard stubs for static local initialization (single-threaded, no-op).
+// Own translation unit, so function-local statics do not drag new/delete and
+// with them malloc/free into the image.
+extern "C" {
+int __cxa_guard_acquire(uint8_t *g) {
+  return !(*g);
+}
+
+void __cxa_guard_release(uint8_t *g) {
+  *g = 1;
+}
+
+void __cxa_guard_abort(uint8_t *) {}
+}
+#endif
@@ -1,8 +1,9 @@
-#ifdef __AVR__
+#if defined(__AVR__) && !defined(NO_HEAP)
 #include <stdlib.h>
-#include <stdint.h>
 
-// Simple new/delete operators for AVR - uses malloc/free
+// Simple new/delete operators for AVR - uses malloc/free.
+// With NO_HEAP (USE_HEAP=OFF) they are left out and Utils/NoHeap.h turns
+// every new-expression into a compile error.
 void* operator new(size_t size) { return malloc(size); }
 
 void* operator new[](size_t size) { return malloc(size); }
@@ -14,17 +15,4 @@ void operator delete[](void* ptr) { free(ptr); }
 void operator delete(void* ptr, size_t) { free(ptr); }
 
 void operator delete[](void* ptr, size_t) { free(ptr); }
-
-// C++ Guard stubs for static local initialization (single-threaded, no-op)
-extern "C" {
-int __cxa_guard_acquire(uint8_t *g) {
-  return !(*g);
-}
-
-void __cxa_guard_release(uint8_t *g) {
-  *g = 1;
-}
-
-void __cxa_guard_abort(uint8_t *) {}
-}
 #endif
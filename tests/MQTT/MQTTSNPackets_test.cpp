@@ -0,0 +1,45 @@
+#include "MQTT/MQTTSNPackets.h"
+#include <gtest/gtest.h>
+#include <cstring>
+
+namespace {
+
+TEST(MQTTSNPacketsTest, PublishQosMinusOne) {
+  uint8_t buffer[24];
+  const uint8_t payload[] = {'1'};
+
+  uint8_t length = MQTT::SN::build_publish(buffer, sizeof(buffer), 0x0102,
+                                           MQTT::SN::QoS::kMinusOne, payload, sizeof(payload));
+
+  const uint8_t expected[] = {8, 0x0C, 0x61, 0x01, 0x02, 0x00, 0x00, '1'};
+  ASSERT_EQ(length, sizeof(expected));
+  EXPECT_EQ(0, memcmp(buffer, expected, sizeof(expected)));
+}
+
+TEST(MQTTSNPacketsTest, PublishQosZeroFlags) {
+  uint8_t buffer[24];
+  uint8_t length =
+      MQTT::SN::build_publish(buffer, sizeof(buffer), 1, MQTT::SN::QoS::kAtMostOnce, nullptr, 0);
+  ASSERT_EQ(length, MQTT::SN::kPublishHeaderLength);
+  EXPECT_EQ(buffer[2], MQTT::SN::kTopicIdPredefined);
+}
+
+TEST(MQTTSNPacketsTest, PublishTooLarge) {
+  uint8_t buffer[10];
+  const uint8_t payload[4] = {};
+  EXPECT_EQ(0, MQTT::SN::build_publish(buffer, sizeof(buffer), 1, MQTT::SN::QoS::kMinusOne,
+                                       payload, sizeof(payload)));
+}
+
+TEST(MQTTSNPacketsTest, Connect) {
+  uint8_t buffer[24];
+  uint8_t length = MQTT::SN::build_connect(buffer, sizeof(buffer), "bell", 60);
+
+  const uint8_t expected[] = {10, 0x04, 0x04, 0x01, 0x00, 60, 'b', 'e', 'l', 'l'};
+  ASSERT_EQ(length, sizeof(expected));
+  EXPECT_EQ(0, memcmp(buffer, expected, sizeof(expected)));
+
+  EXPECT_EQ(0, MQTT::SN::build_connect(buffer, 8, "bell", 60));
+}
+
+}  // namespace
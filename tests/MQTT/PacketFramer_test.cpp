@@ -0,0 +1,108 @@
+#include "MQTT/PacketFramer.h"
+#include <gtest/gtest.h>
+#include <cstring>
+
+namespace {
+
+constexpr uint16_t kBufferSize = 32;
+
+class PacketFramerTest : public ::testing::Test {
+ protected:
+  PacketFramerTest() : framer_(buffer_, kBufferSize) {}
+
+  // Simulates one recv() of the given bytes
+  uint16_t receive(const uint8_t* data, uint16_t length) {
+    uint16_t n = (length < framer_.free_length()) ? length : framer_.free_length();
+    memcpy(framer_.free_space(), data, n);
+    framer_.commit(n);
+    return n;
+  }
+
+  uint8_t buffer_[kBufferSize];
+  MQTT::PacketFramer framer_;
+};
+
+const uint8_t kPingresp[] = {0xD0, 0x00};
+const uint8_t kPublish[] = {0x30, 0x06, 0x00, 0x01, 'a', 'O', 'N', '!'};
+
+TEST_F(PacketFramerTest, SinglePacket) {
+  MQTT::Packet packet;
+  EXPECT_FALSE(framer_.next(packet));
+
+  receive(kPublish, sizeof(kPublish));
+  ASSERT_TRUE(framer_.next(packet));
+  EXPECT_EQ(packet.header, 0x30);
+  EXPECT_EQ(packet.length, 6);
+  EXPECT_EQ(packet.body[2], 'a');
+  EXPECT_FALSE(framer_.next(packet));
+}
+
+TEST_F(PacketFramerTest, CoalescedPackets) {
+  uint8_t segment[sizeof(kPingresp) + sizeof(kPublish)];
+  memcpy(segment, kPingresp, sizeof(kPingresp));
+  memcpy(&segment[sizeof(kPingresp)], kPublish, sizeof(kPublish));
+  receive(segment, sizeof(segment));
+
+  MQTT::Packet packet;
+  ASSERT_TRUE(framer_.next(packet));
+  EXPECT_EQ(packet.header, 0xD0);
+  EXPECT_EQ(packet.length, 0);
+  ASSERT_TRUE(framer_.next(packet));
+  EXPECT_EQ(packet.header, 0x30);
+  EXPECT_EQ(0, memcmp(packet.body, &kPublish[2], 6));
+  EXPECT_FALSE(framer_.next(packet));
+  EXPECT_EQ(framer_.free_length(), kBufferSize);
+}
+
+TEST_F(PacketFramerTest, FragmentedPacket) {
+  MQTT::Packet packet;
+
+  // Byte by byte, as if every recv() returned a single byte
+  for (uint16_t i = 0; i < sizeof(kPublish) - 1; i++) {
+    receive(&kPublish[i], 1);
+    EXPECT_FALSE(framer_.next(packet));
+  }
+  receive(&kPublish[sizeof(kPublish) - 1], 1);
+  ASSERT_TRUE(framer_.next(packet));
+  EXPECT_EQ(packet.length, 6);
+  EXPECT_EQ(packet.body[5], '!');
+}
+
+TEST_F(PacketFramerTest, MultiByteRemainingLength) {
+  // Remaining length 130 = 0x82 0x01, larger than the buffer: skipped
+  uint8_t header[] = {0x30, 0x82, 0x01};
+  receive(header, sizeof(header));
+
+  MQTT::Packet packet;
+  EXPECT_FALSE(framer_.next(packet));
+  EXPECT_EQ(framer_.dropped(), 1);
+
+  uint8_t filler[kBufferSize];
+  memset(filler, 'x', sizeof(filler));
+  uint16_t left = 130;
+  while (left > 0) {
+    uint16_t n = receive(filler, (left < sizeof(filler)) ? left : sizeof(filler));
+    left -= n;
+    EXPECT_FALSE(framer_.next(packet));
+  }
+
+  // Stream is in sync again
+  receive(kPingresp, sizeof(kPingresp));
+  ASSERT_TRUE(framer_.next(packet));
+  EXPECT_EQ(packet.header, 0xD0);
+  EXPECT_FALSE(framer_.error());
+}
+
+TEST_F(PacketFramerTest, MalformedRemainingLength) {
+  uint8_t header[] = {0x30, 0xFF, 0xFF, 0xFF, 0xFF, 0x01};
+  receive(header, sizeof(header));
+
+  MQTT::Packet packet;
+  EXPECT_FALSE(framer_.next(packet));
+  EXPECT_TRUE(framer_.error());
+
+  framer_.reset();
+  EXPECT_FALSE(framer_.error());
+}
+
+}  // namespace
@@ -0,0 +1,81 @@
+#include "MQTT/PacketTemplates.h"
+#include "Utils/FlashString.h"
+#include <gtest/gtest.h>
+#include <cstring>
+
+namespace {
+
+constexpr char kTopic[] = "smartbell/bellbutton/frontdoor/active";
+
+// Compile-time checks: these packets never exist as runtime code
+static_assert(MQTT::kPingreqPacket.bytes[0] == 0xC0 && MQTT::kPingreqPacket.bytes[1] == 0,
+              "PINGREQ template");
+static_assert(MQTT::kDisconnectPacket.bytes[0] == 0xE0, "DISCONNECT template");
+static_assert(MQTT::make_prepared_publish(kTopic, 0).header_length == 4,
+              "Short PUBLISH uses one remaining-length byte");
+
+TEST(PacketTemplatesTest, ConnectProtocolHeader) {
+  const uint8_t expected[] = {0, 4, 'M', 'Q', 'T', 'T', 4};
+  ASSERT_EQ(MQTT::kConnectProtocolHeader.size(), sizeof(expected));
+  EXPECT_EQ(0, memcmp(MQTT::kConnectProtocolHeader.bytes, expected, sizeof(expected)));
+  EXPECT_EQ(MQTT::kConnectVariableHeaderLength, 10);
+}
+
+TEST(PacketTemplatesTest, ConnectFlags) {
+  EXPECT_EQ(MQTT::connect_flags(true, false), 0x02);
+  EXPECT_EQ(MQTT::connect_flags(false, false), 0x00);
+  EXPECT_EQ(MQTT::connect_flags(true, true), 0xC2);
+}
+
+TEST(PacketTemplatesTest, ConnectFlagsWithWill) {
+  EXPECT_EQ(MQTT::connect_flags(true, false, true), 0x06);
+  EXPECT_EQ(MQTT::connect_flags(true, false, true, MQTT::QoS::kAtLeastOnce, true), 0x2E);
+  // QoS and retain are ignored without a will
+  EXPECT_EQ(MQTT::connect_flags(false, false, false, MQTT::QoS::kAtLeastOnce, true), 0x00);
+}
+
+TEST(PacketTemplatesTest, PreparedPublishShortTopic) {
+  constexpr MQTT::PreparedPublish packet = MQTT::make_prepared_publish(kTopic, 1);
+  const uint8_t topic_len = sizeof(kTopic) - 1;
+
+  EXPECT_EQ(packet.header[0], 0x30);
+  EXPECT_EQ(packet.header[1], 2 + topic_len + 1);
+  EXPECT_EQ(packet.header[2], 0);
+  EXPECT_EQ(packet.header[3], topic_len);
+  EXPECT_EQ(packet.topic, kTopic);
+  EXPECT_EQ(packet.topic_length, topic_len);
+  EXPECT_EQ(packet.payload_length, 1);
+}
+
+TEST(PacketTemplatesTest, PreparedPublishTwoByteRemainingLength) {
+  MQTT::PreparedPublish packet = MQTT::prepare_publish_header("a/b", 3, 200);
+
+  // remaining = 2 + 3 + 200 = 205 -> 0xCD 0x01
+  ASSERT_EQ(packet.header_length, 5);
+  EXPECT_EQ(packet.header[1], 0xCD);
+  EXPECT_EQ(packet.header[2], 0x01);
+  EXPECT_EQ(packet.header[4], 3);
+}
+
+TEST(PacketTemplatesTest, PreparedPublishFromFlash) {
+  static constexpr char kFlashTopic[] PROGMEM = "smartbell/status";
+  constexpr MQTT::PreparedPublish kPacket = MQTT::make_prepared_publish_P(kFlashTopic, 0);
+  constexpr MQTT::PreparedPublish kRamPacket = MQTT::make_prepared_publish(kFlashTopic, 0);
+
+  EXPECT_TRUE(kPacket.topic_in_flash);
+  EXPECT_FALSE(kRamPacket.topic_in_flash);
+  EXPECT_EQ(kPacket.topic, kFlashTopic);
+  EXPECT_EQ(kPacket.topic_length, sizeof(kFlashTopic) - 1);
+  EXPECT_EQ(kPacket.header_length, kRamPacket.header_length);
+  EXPECT_EQ(memcmp(kPacket.header, kRamPacket.header, kPacket.header_length), 0);
+}
+
+TEST(PacketTemplatesTest, RemainingLengthSize) {
+  EXPECT_EQ(MQTT::remaining_length_size(0), 1);
+  EXPECT_EQ(MQTT::remaining_length_size(127), 1);
+  EXPECT_EQ(MQTT::remaining_length_size(128), 2);
+  EXPECT_EQ(MQTT::remaining_length_size(16383), 2);
+  EXPECT_EQ(MQTT::remaining_length_size(16384), 3);
+}
+
+}  // namespace
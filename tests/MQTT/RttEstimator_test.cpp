@@ -0,0 +1,81 @@
+#include "MQTT/RttEstimator.h"
+#include <gtest/gtest.h>
+
+namespace {
+
+TEST(RttEstimatorTest, DefaultBeforeFirstSample) {
+  MQTT::RttEstimator rtt;
+  EXPECT_FALSE(rtt.has_sample());
+  EXPECT_EQ(rtt.rto_ms(), MQTT::RttEstimator::kInitialRtoMs);
+}
+
+TEST(RttEstimatorTest, FirstSampleSetsSrttAndVariance) {
+  MQTT::RttEstimator rtt;
+  rtt.add_sample(100);
+  EXPECT_TRUE(rtt.has_sample());
+  EXPECT_EQ(rtt.srtt_ms(), 100);
+  EXPECT_EQ(rtt.rto_ms(), 300);  // 100 + 4 * 50
+}
+
+TEST(RttEstimatorTest, ConvergesOnStableRtt) {
+  MQTT::RttEstimator rtt;
+  rtt.add_sample(400);
+  for (int i = 0; i < 100; i++) {
+    rtt.add_sample(100);
+  }
+  EXPECT_EQ(rtt.srtt_ms(), 100);
+  EXPECT_LT(rtt.rto_ms(), 110);
+}
+
+TEST(RttEstimatorTest, ClampsToLanFloorAndCeiling) {
+  MQTT::RttEstimator lan;
+  for (int i = 0; i < 20; i++) {
+    lan.add_sample(1);
+  }
+  EXPECT_EQ(lan.rto_ms(), MQTT::RttEstimator::kMinRtoMs);
+
+  MQTT::RttEstimator slow;
+  slow.add_sample(5000);
+  EXPECT_EQ(slow.rto_ms(), MQTT::RttEstimator::kMaxRtoMs);
+}
+
+TEST(RttEstimatorTest, BackoffConvergesUpwardToSlowBroker) {
+  // Every exchange with a 600 ms broker outlasts the initial 200 ms RTO, so
+  // Karn drops the sample; only the backoff gets the RTO past the real RTT
+  MQTT::RttEstimator rtt;
+  const uint16_t kRttMs = 600;
+  for (int i = 0; i < 20; i++) {
+    if (kRttMs < rtt.rto_ms()) {
+      rtt.add_sample(kRttMs);
+    } else {
+      rtt.backoff();
+    }
+  }
+  EXPECT_TRUE(rtt.has_sample());
+  EXPECT_EQ(rtt.srtt_ms(), kRttMs);
+  EXPECT_GT(rtt.rto_ms(), kRttMs);
+}
+
+TEST(RttEstimatorTest, BackoffDoublesUpToCeiling) {
+  MQTT::RttEstimator rtt;
+  rtt.backoff();
+  EXPECT_EQ(rtt.rto_ms(), 400);
+  rtt.backoff();
+  rtt.backoff();
+  EXPECT_EQ(rtt.rto_ms(), 1600);
+  rtt.backoff();
+  EXPECT_EQ(rtt.rto_ms(), MQTT::RttEstimator::kMaxRtoMs);
+  // A valid sample ends the backoff
+  rtt.add_sample(100);
+  EXPECT_EQ(rtt.rto_ms(), 100 + 200);
+}
+
+TEST(RttEstimatorTest, W5500TimeoutDoublesPerRetry) {
+  EXPECT_EQ(MQTT::RttEstimator::timeout_ms(50, 0), 50U);
+  EXPECT_EQ(MQTT::RttEstimator::timeout_ms(50, 3), 50U + 100U + 200U + 400U);
+  // W5500 defaults (200 ms, 8 retries): RTR caps at 6553 ms
+  EXPECT_EQ(MQTT::RttEstimator::timeout_ms(200, 8),
+            200U + 400U + 800U + 1600U + 3200U + 6400U + 3 * 6553U);
+}
+
+}  // namespace
@@ -0,0 +1,86 @@
+#include "MQTT/TopicFilter.h"
+#include <gtest/gtest.h>
+#include <cstring>
+
+namespace {
+
+bool matches(const char* filter, const char* topic) {
+  MQTT::TopicFilter compiled;
+  if (!compiled.compile(filter)) {
+    return false;
+  }
+  MQTT::TopicHashes hashes;
+  hashes.compute(topic, strlen(topic));
+  return compiled.matches(hashes) && compiled.confirm(filter, false, topic, strlen(topic));
+}
+
+TEST(TopicFilterTest, ExactMatch) {
+  EXPECT_TRUE(matches("smartbell/gong/1", "smartbell/gong/1"));
+  EXPECT_FALSE(matches("smartbell/gong/1", "smartbell/gong/2"));
+  EXPECT_FALSE(matches("smartbell/gong", "smartbell/gong/1"));
+  EXPECT_FALSE(matches("smartbell/gong/1", "smartbell/gong"));
+}
+
+TEST(TopicFilterTest, HashCollisionIsConfirmedAgainstFilter) {
+  // "1" and "fg7" share the 16-bit level hash
+  ASSERT_EQ(MQTT::topic_level_hash("1", 1), MQTT::topic_level_hash("fg7", 3));
+
+  MQTT::TopicFilter compiled;
+  ASSERT_TRUE(compiled.compile("smartbell/gong/1"));
+  MQTT::TopicHashes hashes;
+  const char* topic = "smartbell/gong/fg7";
+  hashes.compute(topic, strlen(topic));
+  EXPECT_TRUE(compiled.matches(hashes));  // The fast path alone is fooled
+  EXPECT_FALSE(compiled.confirm("smartbell/gong/1", false, topic, strlen(topic)));
+
+  EXPECT_FALSE(matches("smartbell/gong/1", "smartbell/gong/fg7"));
+  EXPECT_FALSE(matches("smartbell/+/1", "smartbell/ring/fg7"));
+  EXPECT_FALSE(matches("smartbell/1/#", "smartbell/fg7/state"));
+  EXPECT_TRUE(matches("smartbell/+/1", "smartbell/ring/1"));
+}
+
+TEST(TopicFilterTest, SingleLevelWildcard) {
+  EXPECT_TRUE(matches("smartbell/gong/+", "smartbell/gong/1"));
+  EXPECT_TRUE(matches("smartbell/gong/+", "smartbell/gong/2"));
+  EXPECT_TRUE(matches("smartbell/+/status", "smartbell/gong/status"));
+  EXPECT_FALSE(matches("smartbell/gong/+", "smartbell/gong/upperfloor/status"));
+  EXPECT_FALSE(matches("smartbell/gong/+", "smartbell/gong"));
+  EXPECT_TRUE(matches("smartbell/gong/+", "smartbell/gong/"));  // Empty level
+}
+
+TEST(TopicFilterTest, MultiLevelWildcard) {
+  EXPECT_TRUE(matches("smartbell/gong/#", "smartbell/gong/testgong"));
+  EXPECT_TRUE(matches("smartbell/gong/#", "smartbell/gong/upperfloor/testgong"));
+  EXPECT_TRUE(matches("smartbell/gong/#", "smartbell/gong"));  // Parent level
+  EXPECT_FALSE(matches("smartbell/gong/#", "smartbell/bellbutton/office/active"));
+  EXPECT_TRUE(matches("#", "a/b/c/d/e/f/g/h"));  // Deeper than kMaxTopicLevels
+}
+
+TEST(TopicFilterTest, SystemTopicsNeedExplicitPrefix) {
+  EXPECT_FALSE(matches("#", "$SYS/broker/uptime"));
+  EXPECT_FALSE(matches("+/broker/uptime", "$SYS/broker/uptime"));
+  EXPECT_TRUE(matches("$SYS/#", "$SYS/broker/uptime"));
+}
+
+TEST(TopicFilterTest, RejectsMalformedFilters) {
+  MQTT::TopicFilter filter;
+  EXPECT_FALSE(filter.compile(""));
+  EXPECT_FALSE(filter.compile(nullptr));
+  EXPECT_FALSE(filter.compile("smartbell/#/gong"));
+  EXPECT_FALSE(filter.compile("smartbell/gong#"));
+  EXPECT_FALSE(filter.compile("smartbell/go+ng"));
+  EXPECT_FALSE(filter.compile("a/b/c/d/e/f/g"));  // More levels than kMaxTopicLevels
+  EXPECT_TRUE(filter.compile("a/b/c/d/e/f/#"));
+}
+
+TEST(TopicFilterTest, TopicWithoutTerminator) {
+  // Topics are hashed straight from the receive buffer
+  const char buffer[] = "smartbell/gong/1XXXX";
+  MQTT::TopicFilter filter;
+  ASSERT_TRUE(filter.compile("smartbell/gong/1"));
+  MQTT::TopicHashes hashes;
+  hashes.compute(buffer, 16);
+  EXPECT_TRUE(filter.matches(hashes));
+}
+
+}  // namespace
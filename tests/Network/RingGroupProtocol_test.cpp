@@ -0,0 +1,107 @@
+#include "Network/RingGroupProtocol.h"
+#include <gtest/gtest.h>
+#include <cstring>
+
+namespace {
+
+using Network::RingGroup::Datagram;
+using Network::RingGroup::DedupeWindow;
+using Network::RingGroup::decode;
+using Network::RingGroup::encode;
+using Network::RingGroup::kDatagramLength;
+
+const uint8_t kKey[16] = {0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77,
+                          0x88, 0x99, 0xAA, 0xBB, 0xCC, 0xDD, 0xEE, 0xFF};
+
+TEST(RingGroupProtocolTest, EncodeDecodeRoundtrip) {
+  Datagram sent = {7, 0xBEEF, 0x02, 0x00030001};
+  uint8_t buffer[kDatagramLength];
+  encode(sent, kKey, buffer);
+  EXPECT_EQ(buffer[0], 'R');
+  EXPECT_EQ(buffer[1], 'G');
+
+  Datagram received;
+  ASSERT_TRUE(decode(buffer, sizeof(buffer), kKey, received));
+  EXPECT_EQ(received.group, 7);
+  EXPECT_EQ(received.sender, 0xBEEF);
+  EXPECT_EQ(received.gong_mask, 0x02);
+  EXPECT_EQ(received.sequence, 0x00030001u);
+}
+
+TEST(RingGroupProtocolTest, RejectsForgedOrForeignDatagrams) {
+  Datagram sent = {1, 0x0102, 0x01, 42};
+  uint8_t buffer[kDatagramLength];
+  encode(sent, kKey, buffer);
+  Datagram received;
+
+  // Tampered gong mask
+  uint8_t tampered[kDatagramLength];
+  memcpy(tampered, buffer, sizeof(buffer));
+  tampered[6] ^= 0x03;
+  EXPECT_FALSE(decode(tampered, sizeof(tampered), kKey, received));
+
+  // Wrong key
+  uint8_t other_key[16];
+  memcpy(other_key, kKey, sizeof(other_key));
+  other_key[15] ^= 0x01;
+  EXPECT_FALSE(decode(buffer, sizeof(buffer), other_key, received));
+
+  // Truncated
+  EXPECT_FALSE(decode(buffer, sizeof(buffer) - 1, kKey, received));
+}
+
+TEST(RingGroupProtocolTest, DedupeAcceptsReorderedOnce) {
+  DedupeWindow window;
+  EXPECT_TRUE(window.accept(1, 100));
+  EXPECT_TRUE(window.accept(1, 103));
+  EXPECT_TRUE(window.accept(1, 101));  // Late but inside the window
+  EXPECT_FALSE(window.accept(1, 101));
+  EXPECT_FALSE(window.accept(1, 103));
+  EXPECT_FALSE(window.accept(1, 100));
+  EXPECT_TRUE(window.accept(1, 102));
+
+  // Too old to tell apart from a replay
+  EXPECT_TRUE(window.accept(1, 120));
+  EXPECT_FALSE(window.accept(1, 111));
+}
+
+TEST(RingGroupProtocolTest, DedupeTracksSendersSeparately) {
+  DedupeWindow window;
+  EXPECT_TRUE(window.accept(1, 5));
+  EXPECT_TRUE(window.accept(2, 5));
+  EXPECT_FALSE(window.accept(1, 5));
+  EXPECT_FALSE(window.accept(2, 5));
+
+  // New epoch after a reboot jumps far ahead
+  EXPECT_TRUE(window.accept(1, 0x00010000));
+  EXPECT_FALSE(window.accept(1, 5));
+}
+
+TEST(RingGroupProtocolTest, DedupeRestoredFloorBlocksReplay) {
+  // Receiver rebooted: the persisted floor comes back, old datagrams stay dropped
+  DedupeWindow window;
+  window.restore(1, 0x00020005);
+  EXPECT_FALSE(window.accept(1, 0x00020005));
+  EXPECT_FALSE(window.accept(1, 0x00020001));
+  EXPECT_FALSE(window.accept(1, 0x00010009));
+  EXPECT_TRUE(window.accept(1, 0x00020006));
+
+  uint16_t sender = 0;
+  uint32_t highest = 0;
+  ASSERT_TRUE(window.peer(0, sender, highest));
+  EXPECT_EQ(sender, 1);
+  EXPECT_EQ(highest, 0x00020006u);
+  EXPECT_FALSE(window.peer(1, sender, highest));
+}
+
+TEST(RingGroupProtocolTest, DedupeForgetsEvictedSender) {
+  // The documented replay window: more senders than kMaxPeers
+  DedupeWindow window;
+  EXPECT_TRUE(window.accept(1, 50));
+  for (uint16_t sender = 2; sender <= Network::RingGroup::kMaxPeers + 1; sender++) {
+    EXPECT_TRUE(window.accept(sender, 1));
+  }
+  EXPECT_TRUE(window.accept(1, 50));
+}
+
+}  // namespace
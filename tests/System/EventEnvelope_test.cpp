@@ -0,0 +1,43 @@
+#include "System/EventEnvelope.h"
+#include <gtest/gtest.h>
+
+namespace {
+
+using System::decode_event;
+using System::encode_event;
+using System::EventDedupe;
+using System::EventEnvelope;
+using System::kEventEnvelopeLength;
+
+TEST(EventEnvelopeTest, EncodeDecodeRoundtrip) {
+  EventEnvelope sent = {0x1234, 0x00ABCDEF, 350};
+  uint8_t payload[kEventEnvelopeLength];
+  encode_event(sent, payload);
+  EXPECT_EQ(payload[0], 0x12);
+  EXPECT_EQ(payload[5], 0xEF);
+
+  EventEnvelope received;
+  ASSERT_TRUE(decode_event(payload, sizeof(payload), received));
+  EXPECT_EQ(received.boot_id, 0x1234);
+  EXPECT_EQ(received.sequence, 0x00ABCDEFu);
+  EXPECT_EQ(received.age_ms, 350);
+
+  EXPECT_FALSE(decode_event(payload, 1, received));
+}
+
+TEST(EventEnvelopeTest, DedupeDropsRetries) {
+  EventDedupe dedupe;
+  EXPECT_TRUE(dedupe.accept({7, 1, 0}));
+  EXPECT_FALSE(dedupe.accept({7, 1, 120}));  // Retry, only the age differs
+  EXPECT_TRUE(dedupe.accept({7, 2, 0}));
+  EXPECT_FALSE(dedupe.accept({7, 1, 900}));  // Late retransmission of an older press
+}
+
+TEST(EventEnvelopeTest, DedupeAcceptsNewBoot) {
+  EventDedupe dedupe;
+  EXPECT_TRUE(dedupe.accept({7, 42, 0}));
+  EXPECT_TRUE(dedupe.accept({8, 1, 0}));  // Power cycle restarts the sequence
+  EXPECT_FALSE(dedupe.accept({8, 1, 0}));
+}
+
+}  // namespace
@@ -0,0 +1,69 @@
+#include "System/LogFilter.h"
+#include <gtest/gtest.h>
+
+#include <string>
+
+namespace {
+
+using System::g_log_mask;
+using System::kLogMaskAll;
+using System::log_compiled;
+using System::LogLevel;
+using System::LogModule;
+using System::process_log_command;
+
+class CaptureInterface : public serial::Interface {
+ public:
+  void send(const uint8_t byte) override { text += static_cast<char>(byte); }
+  void send_string(const char *string) override { text += string; }
+  std::string text;
+};
+
+class LogFilterTest : public ::testing::Test {
+ protected:
+  void SetUp() override { g_log_mask = kLogMaskAll; }
+  void TearDown() override { g_log_mask = kLogMaskAll; }
+  CaptureInterface out;
+};
+
+TEST_F(LogFilterTest, DefaultLevelIsInfo) {
+  static_assert(log_compiled(LogModule::kMQTT, LogLevel::kInfo), "Info is built by default");
+  static_assert(!log_compiled(LogModule::kMQTT, LogLevel::kDebug), "Debug is not");
+  static_assert(!log_compiled(LogModule::kAPP, LogLevel::kOff), "kOff never logs");
+  EXPECT_TRUE(log_compiled(LogModule::kBELL, LogLevel::kError));
+}
+
+TEST_F(LogFilterTest, CompiledSitesLog) {
+  SB_LOG_WARN(&out, kNET, "[NET] Link down\r\n");
+  SB_LOG_DEBUG(&out, kNET, "[NET] Not built\r\n");
+  EXPECT_EQ(out.text, "[NET] Link down\r\n");
+}
+
+TEST_F(LogFilterTest, RuntimeMaskMutesModule) {
+  ASSERT_TRUE(process_log_command("log mqtt off", out));
+  EXPECT_EQ(g_log_mask, kLogMaskAll & ~(1 << static_cast<uint8_t>(LogModule::kMQTT)));
+
+  out.text.clear();
+  SB_LOG_ERROR(&out, kMQTT, "[MQTT] Muted\r\n");
+  SB_LOG_ERROR(&out, kCFG, "[CFG] Still on\r\n");
+  EXPECT_EQ(out.text, "[CFG] Still on\r\n");
+
+  ASSERT_TRUE(process_log_command("log all on", out));
+  EXPECT_EQ(g_log_mask, kLogMaskAll);
+}
+
+TEST_F(LogFilterTest, ListsModules) {
+  ASSERT_TRUE(process_log_command("log", out));
+  EXPECT_NE(out.text.find("mqtt level 3 on\r\n"), std::string::npos);
+  EXPECT_NE(out.text.find("app level 3 on\r\n"), std::string::npos);
+}
+
+TEST_F(LogFilterTest, RejectsOtherCommands) {
+  EXPECT_FALSE(process_log_command("logs", out));
+  EXPECT_FALSE(process_log_command("show", out));
+  EXPECT_TRUE(process_log_command("log foo off", out));
+  EXPECT_EQ(g_log_mask, kLogMaskAll);
+  EXPECT_NE(out.text.find("Usage"), std::string::npos);
+}
+
+}  // namespace
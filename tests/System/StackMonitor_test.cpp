@@ -0,0 +1,51 @@
+#include "System/StackMonitor.h"
+#include <gtest/gtest.h>
+
+#include <string.h>
+
+#include <string>
+
+namespace {
+
+using System::count_painted;
+using System::kStackPaint;
+using System::process_mem_command;
+
+class CaptureInterface : public serial::Interface {
+ public:
+  void send(const uint8_t byte) override { text += static_cast<char>(byte); }
+  void send_string(const char *string) override { text += string; }
+  std::string text;
+};
+
+TEST(StackMonitorTest, CountsPaintUpToFirstUsedByte) {
+  uint8_t ram[32];
+  memset(ram, kStackPaint, sizeof(ram));
+  EXPECT_EQ(count_painted(ram, ram + sizeof(ram)), sizeof(ram));
+
+  // Deepest stack frame reached down to ram[20]
+  ram[20] = 0x00;
+  ram[27] = 0x12;
+  EXPECT_EQ(count_painted(ram, ram + sizeof(ram)), 20);
+
+  ram[0] = 0x00;
+  EXPECT_EQ(count_painted(ram, ram + sizeof(ram)), 0);
+  EXPECT_EQ(count_painted(ram, ram), 0);
+}
+
+TEST(StackMonitorTest, MemCommand) {
+  CaptureInterface out;
+  ASSERT_TRUE(process_mem_command("mem", out));
+  // No linker symbols on the host, the line format is what counts
+  EXPECT_EQ(out.text, "data 0 bss 0 heap 0\r\nstack free 0 min 0\r\n");
+}
+
+TEST(StackMonitorTest, IgnoresOtherCommands) {
+  CaptureInterface out;
+  EXPECT_FALSE(process_mem_command("memory", out));
+  EXPECT_FALSE(process_mem_command("me", out));
+  EXPECT_FALSE(process_mem_command("show", out));
+  EXPECT_TRUE(out.text.empty());
+}
+
+}  // namespace
@@ -0,0 +1,81 @@
+#include "System/TokenLog.h"
+#include <gtest/gtest.h>
+
+#include <string>
+
+namespace {
+
+using System::encode_log_frame;
+using System::encode_varint;
+using System::kLogFrameStart;
+using System::kMaxLogFrameSize;
+using System::log_arg;
+using System::log_token;
+
+class CaptureInterface : public serial::Interface {
+ public:
+  void send(const uint8_t byte) override { text += static_cast<char>(byte); }
+  void send_string(const char *string) override { text += string; }
+  std::string text;
+};
+
+TEST(TokenLogTest, VarintLength) {
+  uint8_t out[5];
+  EXPECT_EQ(encode_varint(0, out), 1);
+  EXPECT_EQ(out[0], 0x00);
+  EXPECT_EQ(encode_varint(127, out), 1);
+  EXPECT_EQ(encode_varint(300, out), 2);
+  EXPECT_EQ(out[0], 0xAC);
+  EXPECT_EQ(out[1], 0x02);
+  EXPECT_EQ(encode_varint(0xFFFFFFFF, out), 5);
+  EXPECT_EQ(out[4], 0x0F);
+}
+
+TEST(TokenLogTest, SignedArgsAreZigzag) {
+  EXPECT_EQ(log_arg(0), 0u);
+  EXPECT_EQ(log_arg(-1), 1u);
+  EXPECT_EQ(log_arg(1), 2u);
+  EXPECT_EQ(log_arg(static_cast<int8_t>(-64)), 127u);
+  EXPECT_EQ(log_arg(static_cast<uint8_t>(200)), 200u);
+  EXPECT_EQ(log_arg(0xFFFFFFFFu), 0xFFFFFFFFu);
+}
+
+TEST(TokenLogTest, TokenIsCompileTimeConstant) {
+  static_assert(log_token("[MQTT] Connected\r\n") == log_token("[MQTT] Connected\r\n"),
+                "Token must be deterministic");
+  constexpr uint16_t token = System::LogToken<log_token("[MQTT] Connected\r\n")>::value;
+  EXPECT_NE(token, log_token("[MQTT] Connection dropped\r\n"));
+  // Same value as tools/log_tokens.py computes
+  EXPECT_EQ(log_token("[MQTT] Connection dropped\r\n"), 0x1085);
+}
+
+TEST(TokenLogTest, FrameLayout) {
+  const uint32_t args[] = {5, log_arg(-2)};
+  uint8_t frame[kMaxLogFrameSize];
+  uint8_t size = encode_log_frame(0x1085, 1000, args, 2, frame);
+  // token 2 bytes, timestamp 2 bytes, args 1 byte each
+  ASSERT_EQ(size, 2 + 2 + 2 + 1 + 1);
+  EXPECT_EQ(frame[0], kLogFrameStart);
+  EXPECT_EQ(frame[1], size - 2);
+  EXPECT_EQ(frame[2], 0x85);
+  EXPECT_EQ(frame[3], 0x21);
+  EXPECT_EQ(frame[4], 0xE8);
+  EXPECT_EQ(frame[5], 0x07);
+  EXPECT_EQ(frame[6], 5);
+  EXPECT_EQ(frame[7], 3);
+}
+
+TEST(TokenLogTest, FrameFitsMaxArgs) {
+  const uint32_t args[] = {0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF};
+  uint8_t frame[kMaxLogFrameSize];
+  EXPECT_EQ(encode_log_frame(0xFFFF, 0xFFFFFFFF, args, 5, frame), kMaxLogFrameSize);
+}
+
+TEST(TokenLogTest, TextFallbackFormatsArgs) {
+  CaptureInterface out;
+  System::log_text(&out, "Retry %u of %u, rssi %d, flags 0x%x, 100%\r\n", 2u, 5u, -7, 0xABu);
+  EXPECT_EQ(out.text, "Retry 2 of 5, rssi -7, flags 0xab, 100%\r\n");
+  System::log_text(static_cast<serial::Interface *>(nullptr), "ignored");
+}
+
+}  // namespace
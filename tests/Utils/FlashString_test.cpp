@@ -0,0 +1,45 @@
+#include "Utils/FlashString.h"
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include "Serial/Interface.h"
+
+namespace {
+
+const char kBanner[] PROGMEM = "Smart Bell\r\n";
+
+// Only send() is overridden: the flash overload must not need send_string(const char*)
+class CaptureInterface : public serial::Interface {
+ public:
+  void send(const uint8_t byte) override { text += static_cast<char>(byte); }
+  std::string text;
+};
+
+TEST(FlashStringTest, SendStringStreamsFromFlash) {
+  CaptureInterface out;
+  out.send_string(Utils::as_flash(kBanner));
+  out.send_string(FSTR("ok"));
+  EXPECT_EQ(out.text, "Smart Bell\r\nok");
+}
+
+TEST(FlashStringTest, EmptyStringSendsNothing) {
+  CaptureInterface out;
+  out.send_string(FSTR(""));
+  EXPECT_TRUE(out.text.empty());
+}
+
+TEST(FlashStringTest, Helpers) {
+  const Utils::FlashString* banner = Utils::as_flash(kBanner);
+  EXPECT_EQ(Utils::flash_strlen(banner), sizeof(kBanner) - 1);
+  EXPECT_EQ(Utils::flash_strnlen(banner, 5), 5u);
+  EXPECT_EQ(Utils::flash_char(banner, 6), 'B');
+  EXPECT_EQ(Utils::flash_compare("Smart Bell\r\n", banner), 0);
+  EXPECT_NE(Utils::flash_compare("Smart", banner), 0);
+
+  char copy[6] = {};
+  Utils::flash_copy(copy, banner, 5);
+  EXPECT_STREQ(copy, "Smart");
+}
+
+}  // namespace
@@ -0,0 +1,175 @@
+#!/usr/bin/env python3
+"""Token table and decoder for the tokenized UART log (public/System/TokenLog.h).
+
+  log_tokens.py table src app -o log_tokens.json
+      Collects all SB_LOG(...) format strings and writes token -> format.
+      Fails if two different formats share a 16 bit token.
+
+  stty -F /dev/ttyUSB0 19200 raw && log_tokens.py decode log_tokens.json < /dev/ttyUSB0
+      Rebuilds the text. Bytes outside of frames (plain text logs, console
+      output) are passed through unchanged.
+"""
+
+import argparse
+import json
+import os
+import re
+import sys
+
+FRAME_START = 0x1E
+SOURCE_SUFFIXES = (".c", ".cpp", ".h")
+
+# SB_LOG(out, "literal" ["literal" ...] [, args]), the filtered variants
+# SB_LOG_INFO(out, kMQTT, "literal" ...) and wrappers such as APP_LOG("literal")
+SB_LOG_RE = re.compile(
+    r'\b(?:SB_LOG(?:_[A-Z]+)?|[A-Z]+_LOG)\s*\(\s*(?:[^,()"]+,\s*)*((?:"(?:[^"\\]|\\.)*"\s*)+)'
+)
+LITERAL_RE = re.compile(r'"((?:[^"\\]|\\.)*)"')
+SPEC_RE = re.compile(r"%([udx])")
+
+ESCAPES = {"n": "\n", "r": "\r", "t": "\t", "\\": "\\", '"': '"', "'": "'", "0": "\0"}
+
+
+def unescape(literal):
+    out = []
+    i = 0
+    while i < len(literal):
+        c = literal[i]
+        if c == "\\" and i + 1 < len(literal):
+            i += 1
+            out.append(ESCAPES.get(literal[i], literal[i]))
+        else:
+            out.append(c)
+        i += 1
+    return "".join(out)
+
+
+def log_token(text):
+    """Same as System::log_token(): FNV-1a 32 bit, folded to 16 bit."""
+    value = 2166136261
+    for byte in text.encode("latin-1"):
+        value ^= byte
+        value = (value * 16777619) & 0xFFFFFFFF
+    return ((value >> 16) ^ value) & 0xFFFF
+
+
+def scan(paths):
+    table = {}
+    for root_path in paths:
+        for root, _, files in os.walk(root_path):
+            for name in sorted(files):
+                if not name.endswith(SOURCE_SUFFIXES):
+                    continue
+                path = os.path.join(root, name)
+                with open(path, encoding="utf-8", errors="replace") as source:
+                    text = source.read()
+                for match in SB_LOG_RE.finditer(text):
+                    fmt = "".join(unescape(lit) for lit in LITERAL_RE.findall(match.group(1)))
+                    token = log_token(fmt)
+                    line = text.count("\n", 0, match.start()) + 1
+                    entry = table.get(token)
+                    if entry is not None and entry["format"] != fmt:
+                        sys.exit(
+                            f"Token collision 0x{token:04x}: {entry['source']} and {path}:{line}"
+                        )
+                    table[token] = {"format": fmt, "source": f"{path}:{line}"}
+    return table
+
+
+def write_table(args):
+    table = scan(args.paths)
+    data = {f"{token:04x}": entry for token, entry in sorted(table.items())}
+    with open(args.output, "w", encoding="utf-8") as out:
+        json.dump(data, out, indent=2, ensure_ascii=False)
+    print(f"{len(data)} log tokens -> {args.output}")
+
+
+def read_varint(data, pos):
+    value = 0
+    shift = 0
+    while pos < len(data):
+        byte = data[pos]
+        pos += 1
+        value |= (byte & 0x7F) << shift
+        if not byte & 0x80:
+            return value, pos
+        shift += 7
+    raise ValueError("truncated varint")
+
+
+def format_line(fmt, values):
+    values = iter(values)
+
+    def substitute(match):
+        value = next(values, 0)
+        if match.group(1) == "d":
+            value = (value >> 1) ^ -(value & 1)  # zigzag
+        return f"{value:x}" if match.group(1) == "x" else str(value)
+
+    return SPEC_RE.sub(substitute, fmt)
+
+
+def decode_frame(table, body):
+    token, pos = read_varint(body, 0)
+    timestamp, pos = read_varint(body, pos)
+    values = []
+    while pos < len(body):
+        value, pos = read_varint(body, pos)
+        values.append(value)
+    entry = table.get(f"{token:04x}")
+    if entry is None:
+        return f"[{timestamp:>9} ms] <unknown token 0x{token:04x} {values}>\n"
+    return f"[{timestamp:>9} ms] " + format_line(entry["format"], values).replace("\r", "")
+
+
+def decode(args):
+    with open(args.table, encoding="utf-8") as table_file:
+        table = json.load(table_file)
+    stream = open(args.input, "rb") if args.input else sys.stdin.buffer
+    out = sys.stdout
+    pending = bytearray()
+    while True:
+        chunk = stream.read1(256) if hasattr(stream, "read1") else stream.read(256)
+        if not chunk:
+            break
+        pending += chunk
+        while pending:
+            start = pending.find(FRAME_START)
+            if start < 0:
+                out.write(pending.decode("latin-1").replace("\r", ""))
+                pending.clear()
+                break
+            if start > 0:
+                out.write(pending[:start].decode("latin-1").replace("\r", ""))
+                del pending[:start]
+            if len(pending) < 2 or len(pending) < 2 + pending[1]:
+                break  # Wait for the rest of the frame
+            body = bytes(pending[2 : 2 + pending[1]])
+            del pending[: 2 + len(body)]
+            try:
+                out.write(decode_frame(table, body))
+            except ValueError:
+                out.write("<broken log frame>\n")
+        out.flush()
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawTextHelpFormatter)
+    commands = parser.add_subparsers(dest="command", required=True)
+
+    table_cmd = commands.add_parser("table", help="Generate the token table from the sources")
+    table_cmd.add_argument("paths", nargs="+", help="Source directories to scan")
+    table_cmd.add_argument("-o", "--output", default="log_tokens.json")
+    table_cmd.set_defaults(func=write_table)
+
+    decode_cmd = commands.add_parser("decode", help="Decode a UART log")
+    decode_cmd.add_argument("table", help="log_tokens.json from the build")
+    decode_cmd.add_argument("input", nargs="?", help="Raw UART capture (default: stdin)")
+    decode_cmd.set_defaults(func=decode)
+
+    args = parser.parse_args()
+    args.func(args)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,77 @@
+#!/usr/bin/env python3
+"""Section sizes of the firmware, compared with the previous build.
+
+  size_report.py --size avr-size --state size_report.json app/smart_bell
+
+Prints .text, .data, .bss and .noinit of the ELF. .data is the part of SRAM
+that is filled from flash at startup, every string literal that is not in
+PROGMEM ends up there. The sizes are stored in the state file so the next
+build shows what a change cost (before -> after).
+"""
+
+import argparse
+import json
+import os
+import subprocess
+import sys
+
+SECTIONS = (".text", ".data", ".bss", ".noinit")
+SRAM_SECTIONS = (".data", ".bss", ".noinit")
+SRAM_SIZE = 2048
+FLASH_SIZE = 32768
+
+
+def read_sections(size_cmd, elf):
+    """Parses the SysV output of avr-size -A: name, size, address."""
+    output = subprocess.run([size_cmd, "-A", elf], check=True, capture_output=True, text=True).stdout
+    sizes = dict.fromkeys(SECTIONS, 0)
+    for line in output.splitlines():
+        fields = line.split()
+        if len(fields) >= 2 and fields[0] in sizes and fields[1].isdigit():
+            sizes[fields[0]] = int(fields[1])
+    return sizes
+
+
+def load_previous(path):
+    if not path or not os.path.exists(path):
+        return None
+    try:
+        with open(path, encoding="utf-8") as handle:
+            return json.load(handle)
+    except (OSError, ValueError):
+        return None
+
+
+def print_report(sizes, previous):
+    for name in SECTIONS:
+        line = f"{name:<8} {sizes[name]:6} B"
+        if previous and name in previous and previous[name] != sizes[name]:
+            line += f"   (before {previous[name]}, {sizes[name] - previous[name]:+d})"
+        print(line)
+    flash = sizes[".text"] + sizes[".data"]
+    sram = sum(sizes[name] for name in SRAM_SECTIONS)
+    print(f"Flash    {flash:6} B / {FLASH_SIZE} ({100.0 * flash / FLASH_SIZE:.1f}%)")
+    print(f"SRAM     {sram:6} B / {SRAM_SIZE} ({100.0 * sram / SRAM_SIZE:.1f}%), "
+          f"{SRAM_SIZE - sram} B left for stack")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawTextHelpFormatter)
+    parser.add_argument("elf", help="Linked firmware")
+    parser.add_argument("--size", default="avr-size", help="avr-size binary")
+    parser.add_argument("--state", help="JSON file with the sizes of the previous build")
+    args = parser.parse_args()
+
+    try:
+        sizes = read_sections(args.size, args.elf)
+    except (OSError, subprocess.CalledProcessError) as error:
+        sys.exit(f"size_report: {error}")
+
+    print_report(sizes, load_previous(args.state))
+    if args.state:
+        with open(args.state, "w", encoding="utf-8") as handle:
+            json.dump(sizes, handle, indent=2)
+
+
+if __name__ == "__main__":
+    main()
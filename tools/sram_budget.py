@@ -0,0 +1,129 @@
+#!/usr/bin/env python3
+"""Static SRAM per symbol from the linker map, with a budget check.
+
+  sram_budget.py --budget 1536 app/smart_bell.map
+
+Lists every symbol in .data, .bss and .noinit with its size (largest first),
+then the total. Exits with 1 if the total exceeds --budget: whatever is not
+static is left for the stack, and an overflow silently corrupts .bss.
+
+Sizes come from the input sections of the map. With -fdata-sections every
+variable has its own section; otherwise the symbols of one object file are
+split by their addresses.
+"""
+
+import argparse
+import re
+import sys
+
+SRAM_OUTPUT_SECTIONS = (".data", ".bss", ".noinit")
+
+# " .bss._ZL4dataE  0x00800100  0x40 obj.o" (name may wrap onto its own line).
+# Any input section counts, on AVR .rodata (string literals) lands in .data too.
+INPUT_SECTION_RE = re.compile(r"^ (\.\S+|COMMON)\s*(?:(0x[0-9a-f]+)\s+(0x[0-9a-f]+)\s+(\S.*))?$")
+WRAPPED_RE = re.compile(r"^\s+(0x[0-9a-f]+)\s+(0x[0-9a-f]+)\s+(\S.*)$")
+# "                0x00800100                g_uart"
+SYMBOL_RE = re.compile(r"^\s+(0x[0-9a-f]+)\s+(\S.*)$")
+OUTPUT_SECTION_RE = re.compile(r"^(\.\S+)")
+
+
+def parse_map(lines):
+    """Returns [(size, symbol, object)] for the SRAM sections."""
+    entries = []
+    in_memory_map = False
+    output_section = None
+    current = None  # [address, size, object, [(address, symbol)], input section]
+    pending_name = None
+
+    def flush():
+        if current is None or current[1] == 0:
+            return
+        address, size, obj, symbols, section_name = current
+        if not symbols:
+            # Static locals and string literals have no global symbol
+            entries.append((size, section_name, obj))
+            return
+        symbols.sort()
+        if symbols[0][0] > address:
+            entries.append((symbols[0][0] - address, "(unnamed)", obj))
+        for i, (sym_address, name) in enumerate(symbols):
+            end = symbols[i + 1][0] if i + 1 < len(symbols) else address + size
+            entries.append((end - sym_address, name, obj))
+
+    for line in lines:
+        line = line.rstrip("\n")
+        if line.startswith("Linker script and memory map"):
+            in_memory_map = True
+            continue
+        if not in_memory_map:
+            continue
+        if line.startswith("Cross Reference Table"):
+            break
+
+        top = OUTPUT_SECTION_RE.match(line)
+        if top:
+            flush()
+            current = None
+            output_section = top.group(1)
+            continue
+        if output_section not in SRAM_OUTPUT_SECTIONS:
+            continue
+
+        if pending_name is not None:
+            wrapped = WRAPPED_RE.match(line)
+            section_name, pending_name = pending_name, None
+            if wrapped:
+                flush()
+                current = [int(wrapped.group(1), 16), int(wrapped.group(2), 16), wrapped.group(3), [],
+                           section_name]
+                continue
+
+        section = INPUT_SECTION_RE.match(line)
+        if section:
+            if section.group(2) is None:
+                pending_name = section.group(1)
+                continue
+            flush()
+            current = [int(section.group(2), 16), int(section.group(3), 16), section.group(4), [],
+                       section.group(1)]
+            continue
+
+        symbol = SYMBOL_RE.match(line)
+        if symbol and current is not None and "=" not in symbol.group(2):
+            sym_address = int(symbol.group(1), 16)
+            if current[0] <= sym_address < current[0] + current[1]:
+                current[3].append((sym_address, symbol.group(2).strip()))
+    flush()
+    return entries
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawTextHelpFormatter)
+    parser.add_argument("map", help="Linker map (-Wl,-Map=...)")
+    parser.add_argument("--budget", type=int, default=0, help="Max. static SRAM in bytes (0 = no check)")
+    parser.add_argument("--top", type=int, default=0, help="Only list the largest N symbols")
+    args = parser.parse_args()
+
+    try:
+        with open(args.map, encoding="utf-8", errors="replace") as handle:
+            entries = parse_map(handle)
+    except OSError as error:
+        sys.exit(f"sram_budget: {error}")
+
+    entries.sort(key=lambda entry: (-entry[0], entry[1]))
+    listed = entries[: args.top] if args.top > 0 else entries
+    for size, name, obj in listed:
+        print(f"{size:6}  {name:<40} {obj.rsplit('/', 1)[-1]}")
+
+    total = sum(entry[0] for entry in entries)
+    if args.budget > 0:
+        print(f"Static SRAM: {total} B of {args.budget} B budget")
+        if total > args.budget:
+            print(f"sram_budget: over budget by {total - args.budget} B", file=sys.stderr)
+            sys.exit(1)
+    else:
+        print(f"Static SRAM: {total} B")
+
+
+if __name__ == "__main__":
+    main()